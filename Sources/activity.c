@@ -63,6 +63,7 @@ uint16_t    forward_time;
             set_LED(LED_D, FLASH_ON);
             WAIT_SWITCH_RELEASED(switch_A); 
         } else {
+            MENU_IDLE;      // nothing to do until the next tick
             continue;
         }
 //
@@ -106,7 +107,7 @@ uint16_t    forward_time;
 // Notes
 //
 //      Active switches are 
-//          switch A = go button
+//          switch A = go button (stops the move early if pressed during it)
 //          switch B = change setting by reading POT_1_IN, POT_2_IN and POT_3_IN
 //          switch C = exit mode
 //
@@ -123,6 +124,7 @@ uint8_t do_move(uint8_t direction) {
 uint16_t   forward_time, temp16;
 uint8_t    ad_value, speed;
 int8_t     speed_differential;
+delay_t    move_time;
 
     set_LED(LED_A, FLASH_ON); 
     set_LED(LED_B, FLASH_ON);
@@ -162,10 +164,17 @@ int8_t     speed_differential;
                     break; 
             }
 
-            DelayMs(forward_time);
+            start_delay(&move_time, forward_time);
+            while (delay_expired(&move_time) == NO) {
+                if (switch_A == PRESSED) {          // stop early
+                    break;
+                }
+                CPU_IDLE;
+            }
                           
             vehicle_stop();
             stop_tune();                  
+            WAIT_SWITCH_RELEASED(switch_A);
         }
 //
 // read pots to set system speed, differential bias, and run time
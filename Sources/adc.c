@@ -17,6 +17,271 @@
  ************************************************************************/
 
 #include "global.h"
+//
+// background scan data : 'adc_front' selects the snapshot holding the last
+// complete scan, the other one is being filled by 'adc_isr'
+//
+adc_snapshot_t      adc_snapshot[2];
+volatile uint8_t    adc_front, adc_scan_count;
+uint8_t             adc_scan_chan;
+//
+// filter for each channel, loaded from 'default_adc_filters'
+//
+adc_filter_t        adc_filters[NOS_ADC_CHANNELS];
+uint16_t            adc_sum;                    // ADC_FILTER_AVERAGE accumulator
+uint8_t             adc_samples_left;
+uint8_t             adc_cfg;                    // current ADC1CFG : 8 or 10-bit
+
+#pragma INTO_ROM
+const uint8_t  default_adc_filters[NOS_ADC_CHANNELS][3] = {
+    {ADC_FILTER_IIR, 3, ADC_10BIT},       // BATTERY_VOLTS
+    {ADC_FILTER_AVERAGE, 2, ADC_10BIT},   // POT_3 : 4 conversions
+    {ADC_FILTER_AVERAGE, 2, ADC_10BIT},   // POT_2
+    {ADC_FILTER_AVERAGE, 2, ADC_10BIT},   // POT_1
+    {ADC_FILTER_NONE, 0, ADC_8BIT},       // PAD_SWL
+    {ADC_FILTER_NONE, 0, ADC_8BIT},       // PAD_SWR
+    {ADC_FILTER_MEDIAN3, 0, ADC_8BIT},    // LINE_SENSOR_L
+    {ADC_FILTER_MEDIAN3, 0, ADC_8BIT},    // LINE_SENSOR_R
+    {ADC_FILTER_MEDIAN3, 0, ADC_10BIT},   // FRONT_SENSOR_L : also light sensor
+    {ADC_FILTER_MEDIAN3, 0, ADC_8BIT},    // FRONT_SENSOR_C
+    {ADC_FILTER_MEDIAN3, 0, ADC_10BIT},   // FRONT_SENSOR_R : also light sensor
+    {ADC_FILTER_NONE, 0, ADC_8BIT},       // WHEEL_SENSOR_L : a delay could lose edges
+    {ADC_FILTER_NONE, 0, ADC_8BIT},       // WHEEL_SENSOR_R
+    {ADC_FILTER_MEDIAN3, 0, ADC_8BIT},    // REAR_SENSOR
+};
+
+//----------------------------------------------------------------------------
+// reset_filter : start a filter from a known input value
+// ============
+//
+static void reset_filter(adc_filter_t *filter, uint16_t sample)
+{
+    filter->history[0] = sample;
+    filter->history[1] = sample;
+    filter->state = sample << 6;
+}
+
+//----------------------------------------------------------------------------
+// filter_sample : pass one sample through a channel filter
+// =============
+//
+// Notes
+//      Integer only, on 10-bit values (8-bit conversions are scaled up).
+//      For ADC_FILTER_AVERAGE 'adc_sum' holds the sum of 2^param
+//      conversions.  The IIR state is the output in 10.6 fixed point :
+//      y = y - y/2^k + x/2^k, which cannot overflow 16 bits.
+//
+static uint16_t filter_sample(adc_filter_t *filter, uint16_t sample)
+{
+uint16_t   a, b, tmp;
+
+    switch (filter->type) {
+        case ADC_FILTER_AVERAGE :
+            return (adc_sum >> filter->param);
+        case ADC_FILTER_MEDIAN3 :
+            a = filter->history[0];
+            b = filter->history[1];
+            filter->history[0] = b;
+            filter->history[1] = sample;
+            if (a > b) {                // order so that a <= b
+                tmp = a;
+                a = b;
+                b = tmp;
+            }
+            if (sample <= a) {
+                return a;
+            }
+            if (sample >= b) {
+                return b;
+            }
+            return sample;
+        case ADC_FILTER_IIR :
+            filter->state = filter->state - (filter->state >> filter->param)
+                                + (sample << (6 - filter->param));
+            return ((filter->state + 0x20) >> 6);
+        default :
+            return sample;
+    }
+}
+
+//----------------------------------------------------------------------------
+// select_resolution : set converter to 8 or 10-bit mode for a channel
+// =================
+//
+static void select_resolution(uint8_t chan)
+{
+uint8_t   cfg;
+
+    cfg = (adc_filters[chan].resolution == ADC_10BIT) ? ADC_CFG_10BIT : ADC_CFG_8BIT;
+    if (cfg != adc_cfg) {                      // only written when mode changes
+        ADC1CFG = cfg;
+        adc_cfg = cfg;
+    }
+}
+
+//----------------------------------------------------------------------------
+// start_conversion : start first conversion of a channel in the scan
+// ================
+//
+static void start_conversion(uint8_t chan)
+{
+    if (adc_filters[chan].type == ADC_FILTER_AVERAGE) {
+        adc_sum = 0;
+        adc_samples_left = 1 << adc_filters[chan].param;
+    }
+    select_resolution(chan);
+    ADC1SC1 = (AD_INT_EN | AD_SING_CONV | chan);
+}
+
+//----------------------------------------------------------------------------
+// read_result : read conversion result scaled to 10 bits
+// ===========
+//
+// Notes
+//      Reading the result clears COCO.
+//
+static uint16_t read_result(void)
+{
+    if (adc_cfg == ADC_CFG_10BIT) {
+        return ADC1R;
+    } else {
+        return ((uint16_t)ADC1RL << 2);
+    }
+}
+
+//----------------------------------------------------------------------------
+// adc_scan_init : fill both snapshots before interrupts are enabled
+// =============
+//
+// Notes
+//      Polled conversion of every channel so 'get_adc' has valid data
+//      from the start, and the filters start from that value.  Leaves
+//      the scan idle until the first RTI.
+//
+void adc_scan_init(void)
+{
+uint8_t    chan;
+uint16_t   sample;
+
+    adc_cfg = ADC_CFG_8BIT;                    // as set by Init_adc
+    for (chan = 0 ; chan < NOS_ADC_CHANNELS ; chan++) {
+        adc_filters[chan].type = default_adc_filters[chan][0];
+        adc_filters[chan].param = default_adc_filters[chan][1];
+        adc_filters[chan].resolution = default_adc_filters[chan][2];
+        select_resolution(chan);
+        ADC1SC1 = (AD_INT_DIS | AD_SING_CONV | chan);
+        while(!ADC1SC1_COCO)
+            ;
+        sample = read_result();
+        reset_filter(&adc_filters[chan], sample);
+        adc_snapshot[0].full[chan] = sample;
+        adc_snapshot[0].value[chan] = (uint8_t)(sample >> 2);
+        adc_snapshot[0].raw[chan] = (uint8_t)(sample >> 2);
+        adc_snapshot[0].tick[chan] = timer_ticks;
+    }
+    adc_snapshot[1] = adc_snapshot[0];
+    adc_front = 0;
+    adc_scan_chan = NOS_ADC_CHANNELS;          // idle
+}
+
+//----------------------------------------------------------------------------
+// start_adc_scan : start a scan of all a/d channels
+// ==============
+//
+// Notes
+//      Run as an RTI task every 8mS.  Conversions are chained by the
+//      ADC complete interrupt, so no code waits for the converter.  With
+//      the default filters a scan is 23 conversions (each pot is averaged
+//      over 4) : about 210uS of conversion time at ADCK = BUSCLK/8, plus
+//      one run of 'adc_isr' per conversion.
+//
+void start_adc_scan(void)
+{
+    if (adc_scan_chan < NOS_ADC_CHANNELS) {     // last scan not finished
+        return;
+    }
+    adc_scan_chan = 0;
+    start_conversion(0);
+}
+
+//----------------------------------------------------------------------------
+// adc_isr : handle ADC conversion complete interrupt
+// =======
+//
+// Description
+//      Filter the result and store it (10-bit and 8-bit views), the raw
+//      value and the time in the back snapshot then start the next channel.  An averaged channel
+//      is converted 2^param times before moving on.  After the last
+//      channel the back snapshot becomes the front one and the converter
+//      is left idle.
+//
+void adc_isr(void)
+{
+adc_snapshot_t   *back;
+adc_filter_t     *filter;
+uint16_t         sample, filtered;
+
+    sample = read_result();
+    filter = &adc_filters[adc_scan_chan];
+    if (filter->type == ADC_FILTER_AVERAGE) {
+        adc_sum += sample;
+        adc_samples_left--;
+        if (adc_samples_left != 0) {
+            ADC1SC1 = (AD_INT_EN | AD_SING_CONV | adc_scan_chan);
+            return;
+        }
+    }
+    back = &adc_snapshot[adc_front ^ 1];
+    filtered = filter_sample(filter, sample);
+    back->raw[adc_scan_chan] = (uint8_t)(sample >> 2);
+    back->full[adc_scan_chan] = filtered;
+    back->value[adc_scan_chan] = (uint8_t)(filtered >> 2);
+    back->tick[adc_scan_chan] = timer_ticks;
+    adc_scan_chan++;
+    if (adc_scan_chan < NOS_ADC_CHANNELS) {
+        start_conversion(adc_scan_chan);
+    } else {
+        adc_front ^= 1;
+        adc_scan_count++;
+        ADC1SC1 = (AD_INT_DIS | AD_SING_CONV | AD_CHAN_DIS);
+    }
+}
+
+//----------------------------------------------------------------------------
+// set_adc_filter : change the filter used on a channel
+// ==============
+//
+// Parameters
+//      chan   : a/d channel
+//      type   : ADC_FILTER_NONE, ADC_FILTER_AVERAGE, ADC_FILTER_MEDIAN3
+//               or ADC_FILTER_IIR
+//      param  : ADC_FILTER_AVERAGE : average 2^param conversions (0->4)
+//               ADC_FILTER_IIR     : time constant 2^param scans (1->6)
+//
+// Notes
+//      Filter restarts from the last raw value of the channel.
+//      Returns FAIL if the parameters are out of range.
+//
+uint8_t set_adc_filter(a2d_channels_t chan, uint8_t type, uint8_t param)
+{
+    if ((chan >= NOS_ADC_CHANNELS) || (type > ADC_FILTER_IIR)) {
+        return FAIL;
+    }
+    if (((type == ADC_FILTER_AVERAGE) && (param > 4)) ||
+        ((type == ADC_FILTER_IIR) && ((param == 0) || (param > 6)))) {
+        return FAIL;
+    }
+    DISABLE_INTERRUPTS;
+    adc_filters[chan].type = type;
+    adc_filters[chan].param = param;
+    reset_filter(&adc_filters[chan], adc_snapshot[adc_front].full[chan]);
+    if (chan == adc_scan_chan) {               // restart average in progress
+        adc_sum = 0;
+        adc_samples_left = 1 << param;
+    }
+    ENABLE_INTERRUPTS;
+    return OK;
+}
 
 //***********************************************************************
 //** Function:      get_adc
@@ -25,42 +290,68 @@
 //** Returns:       char      - ADC value
 //
 // Notes
-//      Protect from interrupts as an interrupt routine will
-//      want to access the analogue channels.
+//      Returns the filtered value from the last complete background
+//      scan, at most about 8mS old.  Does not wait and does not disable
+//      interrupts, so it can also be used from interrupt routines.
+//      Returns 0 for a channel that is not scanned.
 //
-//*********************************************************************** 
-uint8_t get_adc(a2d_channels_t chan) 
+//***********************************************************************
+uint8_t get_adc(a2d_channels_t chan)
 {
-uint8_t   adc_value;
-
-
-    DISABLE_INTERRUPTS;
+    if (chan >= NOS_ADC_CHANNELS) {
+        return 0;
+    }
+    return adc_snapshot[adc_front].value[chan];
+}
 
-    ADC1SC1_ADCH = chan;
-    while(!ADC1SC1_COCO)
-        ;
-    adc_value = ADC1RL;
-    
-    ENABLE_INTERRUPTS;
-                   
-    return adc_value;
-    
+//----------------------------------------------------------------------------
+// get_adc10 : filtered value of a channel on a 10-bit scale (0->1023)
+// =========
+//
+// Notes
+//      Full resolution for channels converted in 10-bit mode (see
+//      'default_adc_filters'), others are the 8-bit value times 4.
+//      No need to disable interrupts for the 16-bit read as 'adc_isr'
+//      only writes the back snapshot.  Returns 0 for a channel that is
+//      not scanned.
+//
+uint16_t get_adc10(a2d_channels_t chan)
+{
+    if (chan >= NOS_ADC_CHANNELS) {
+        return 0;
+    }
+    return adc_snapshot[adc_front].full[chan];
+}
 
+//----------------------------------------------------------------------------
+// get_raw_adc : unfiltered value of a channel from the last scan
+// ===========
+//
+// Notes
+//      Returns 0 for a channel that is not scanned.
+//
+uint8_t get_raw_adc(a2d_channels_t chan)
+{
+    if (chan >= NOS_ADC_CHANNELS) {
+        return 0;
+    }
+    return adc_snapshot[adc_front].raw[chan];
 }
 
 //----------------------------------------------------------------------------
-// interrupt_get_adc : read a/d converter from inside an interrupt routine
-// =================
+// get_adc_snapshot : copy the last complete scan of all channels
+// ================
 //
-// Description
-//      The normal 'get_adc' routine disables/enables the interrupt system
-//      when it operates.  This is necessary since I want to do some a/d
-//      conversions within an interrupt routine.  
-//      
-uint8_t interrupt_get_adc(a2d_channels_t chan) 
+// Notes
+//      Copy is repeated if a scan completes while it is being made, so
+//      all values come from the same scan.
+//
+void get_adc_snapshot(adc_snapshot_t *snapshot)
 {
-    ADC1SC1_ADCH = chan;
-    while(!ADC1SC1_COCO)
-        ;                   
-    return ADC1RL;
-}
\ No newline at end of file
+uint8_t   count;
+
+    do {
+        count = adc_scan_count;
+        *snapshot = adc_snapshot[adc_front];
+    } while (count != adc_scan_count);
+}
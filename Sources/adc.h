@@ -1,7 +1,41 @@
 #ifndef __adc_H
 #define __adc_H
+
+#define   NOS_ADC_CHANNELS    (REAR_SENSOR + 1)
+
+//
+// one complete scan of the a/d channels
+//
+typedef struct {
+    uint8_t     value[NOS_ADC_CHANNELS];     // filtered, 8-bit view
+    uint8_t     raw[NOS_ADC_CHANNELS];       // last single conversion, 8-bit view
+    uint16_t    full[NOS_ADC_CHANNELS];      // filtered, 10-bit scale
+    uint16_t    tick[NOS_ADC_CHANNELS];      // 'timer_ticks' when sampled (never cleared)
+} adc_snapshot_t;
+
+//
+// per-channel filters (see 'set_adc_filter')
+//
+enum {ADC_FILTER_NONE, ADC_FILTER_AVERAGE, ADC_FILTER_MEDIAN3, ADC_FILTER_IIR};
+enum {ADC_8BIT, ADC_10BIT};
+
+#define   ADC_CFG_8BIT     (AD_HS_EN | AD_CLK_DIV_8 | AD_SHORT_SAMPL | AD_CONV_8BIT | AD_CLK_BUSCLK)
+#define   ADC_CFG_10BIT    (AD_HS_EN | AD_CLK_DIV_8 | AD_SHORT_SAMPL | AD_CONV_10BIT | AD_CLK_BUSCLK)
+
+typedef struct {
+    uint8_t     type, param;
+    uint8_t     resolution;                  // ADC_8BIT or ADC_10BIT conversion
+    uint16_t    history[2];                  // ADC_FILTER_MEDIAN3 : last 2 samples
+    uint16_t    state;                       // ADC_FILTER_IIR : output in 10.6 fixed point
+} adc_filter_t;
   
+void adc_scan_init(void);
+void start_adc_scan(void);
+void adc_isr(void);
+uint8_t set_adc_filter(a2d_channels_t chan, uint8_t type, uint8_t param);
 uint8_t get_adc(a2d_channels_t chan);
-uint8_t interrupt_get_adc(a2d_channels_t chan);
+uint16_t get_adc10(a2d_channels_t chan);
+uint8_t get_raw_adc(a2d_channels_t chan);
+void get_adc_snapshot(adc_snapshot_t *snapshot);
 
 #endif /* __adc_H */
\ No newline at end of file
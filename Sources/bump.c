@@ -58,6 +58,7 @@ uint8_t       activity;
             set_LED(LED_D, FLASH_ON);
             WAIT_SWITCH_RELEASED(switch_A); 
         } else {
+            MENU_IDLE;      // nothing to do until the next tick
             continue;       // back to checking switches
         }
 //
@@ -105,9 +106,10 @@ uint8_t run_wall_bump_mode(void) {
 uint8_t       ad_value, bump_L, bump_C, bump_R, bump, time_reverse, time_spin; 
 mode_state_t  state;
 int8_t        speed_differential;
-uint16_t      time; 
+timer_id_t    timeout; 
 
     state = MODE_INIT;
+    timeout = alloc_timer(NULL);
     left_speed = DEFAULT_SPEED;
     right_speed = left_speed - pwm_differential + DIFFERENTIAL_NULL;
     time_reverse = DEFAULT_REVERSE_TIME;
@@ -125,8 +127,7 @@ uint16_t      time;
 //  check for timeout if in RUNNING state
 //
         if (state == MODE_RUNNING) {   
-            GET_TIMER16(time);
-            if (time > LINE_BUMP_TIME_OUT ) {
+            if (timer_expired(timeout) == YES) {
                 state = MODE_INIT;
                 vehicle_stop();
                 continue;
@@ -164,6 +165,7 @@ uint16_t      time;
             vehicle_stop();
             SOUND_EXIT_SELECTION;
             WAIT_SWITCH_RELEASED(switch_C);
+            free_timer(timeout);
             return 0;
         }  
 //
@@ -173,7 +175,7 @@ uint16_t      time;
         if (state == MODE_INIT) {
             if (switch_A == PRESSED) {            //  go to RUN state              
                 state = MODE_RUNNING;
-                CLR_TIMER16;                      // reset timeout timer
+                start_timer(timeout, LINE_BUMP_TIME_OUT, 0);    // start timeout timer
                 WAIT_SWITCH_RELEASED(switch_A); 
             } else {
                 continue;                         // back to begining of FOREVER loop
@@ -324,10 +326,11 @@ uint8_t run_line_bump_mode(void) {
 
 uint8_t       ad_value, line_L, line_R, line, time_reverse, time_spin;
 int8_t        speed_differential;
-uint16_t      time; 
+timer_id_t    timeout; 
 mode_state_t  state;
 
     state = MODE_INIT;
+    timeout = alloc_timer(NULL);
     left_speed = DEFAULT_LINE_BUMP_SPEED;
     right_speed = DEFAULT_LINE_BUMP_SPEED;
     time_reverse = DEFAULT_REVERSE_TIME;
@@ -336,7 +339,6 @@ mode_state_t  state;
     set_LED(LED_B, FLASH_ON);
     set_LED(LED_C, FLASH_ON);
     clr_LED(LED_D);
-    CLR_TIMER16;
 //
 // main loop
 //       
@@ -345,8 +347,7 @@ mode_state_t  state;
 //  check for timeout if in RUNNING state
 //
         if (state == MODE_RUNNING) {   
-            GET_TIMER16(time);
-            if (time > LINE_BUMP_TIME_OUT ) {
+            if (timer_expired(timeout) == YES) {
                 state = MODE_INIT;
                 vehicle_stop();
                 continue;
@@ -385,6 +386,7 @@ mode_state_t  state;
             vehicle_stop();
             SOUND_EXIT_SELECTION;
             WAIT_SWITCH_RELEASED(switch_C);
+            free_timer(timeout);
             return 0;
         }  
 //
@@ -394,7 +396,7 @@ mode_state_t  state;
         if (state == MODE_INIT) {
             if (switch_A == PRESSED) {            //  go to RUN state              
                 state = MODE_RUNNING;
-                CLR_TIMER16;                      // reset timeout timer
+                start_timer(timeout, LINE_BUMP_TIME_OUT, 0);    // start timeout timer
                 WAIT_SWITCH_RELEASED(switch_A); 
             } else {
                 continue;                         // back to begining of FOREVER loop
@@ -499,10 +501,11 @@ uint8_t run_line_bug_bump_mode(void) {
 
 uint8_t       ad_value, line_L, line_R, line, time_reverse, time_spin, time_stop, speed_value;
 int8_t        speed_differential;
-uint16_t      time; 
+timer_id_t    timeout; 
 mode_state_t  state;
 
     state = MODE_INIT;
+    timeout = alloc_timer(NULL);
     left_speed = DEFAULT_LINE_BUMP_SPEED;
     right_speed = DEFAULT_LINE_BUMP_SPEED;
     time_reverse = DEFAULT_REVERSE_TIME;
@@ -511,7 +514,6 @@ mode_state_t  state;
     set_LED(LED_B, FLASH_ON);
     set_LED(LED_C, FLASH_ON);
     clr_LED(LED_D);
-    CLR_TIMER16;
 //
 // main loop
 //       
@@ -520,8 +522,7 @@ mode_state_t  state;
 //  check for timeout if in RUNNING state
 //
         if (state == MODE_RUNNING) {   
-            GET_TIMER16(time);
-            if (time > LINE_BUMP_TIME_OUT ) {
+            if (timer_expired(timeout) == YES) {
                 state = MODE_INIT;
                 vehicle_stop();
                 continue;
@@ -560,6 +561,7 @@ mode_state_t  state;
             vehicle_stop();
             SOUND_EXIT_SELECTION;
             WAIT_SWITCH_RELEASED(switch_C);
+            free_timer(timeout);
             return 0;
         }  
 //
@@ -569,7 +571,7 @@ mode_state_t  state;
         if (state == MODE_INIT) {
             if (switch_A == PRESSED) {            //  go to RUN state              
                 state = MODE_RUNNING;
-                CLR_TIMER16;                      // reset timeout timer
+                start_timer(timeout, LINE_BUMP_TIME_OUT, 0);    // start timeout timer
                 WAIT_SWITCH_RELEASED(switch_A); 
             } else {
                 continue;                         // back to begining of FOREVER loop
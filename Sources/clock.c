@@ -0,0 +1,249 @@
+//----------------------------------------------------------------------------
+//                  Robokid
+//----------------------------------------------------------------------------
+// clock.c : 32-bit microsecond clock
+// =======
+//
+// Description
+//      'get_time_us' returns the microseconds since start-up.  The time is
+//      made from a count of TPM1 overflows, kept by the overflow interrupt
+//      (every 200uS), plus the current TPM1 count.  TPM1 is the motor PWM
+//      counter and runs continuously from the bus clock.
+//
+//      The clock wraps after 71.6 minutes.  Use unsigned differences
+//      (end - start) to measure intervals; these are correct across the wrap.
+//
+//      The 8mS RTI cannot be used as the coarse part of the clock, as it
+//      runs from the internal 1kHz oscillator (+/-30%), not the bus clock.
+//
+//      While idle in the menus TPM1 is slowed and its overflow interrupt
+//      stopped (see 'menu_idle').
+//
+// Author                Date          Comment
+//----------------------------------------------------------------------------
+
+#include "global.h"
+
+//
+// clock data : written only by 'clock_isr' and 'set_clock_rate'
+//
+volatile uint32_t   clock_base_us;          // time of the last TPM1 overflow
+uint8_t             clock_wraps;            // part uS, in bus clock counts (one per overflow)
+uint8_t             clock_shift;            // TPM1 prescaler : 0 or SLOW_CLOCK_SHIFT
+
+//----------------------------------------------------------------------------
+// bus_counts : bus clock counts since 'clock_base_us'
+// ==========
+//
+// Parameters
+//      count   : TPM1CNT
+//      pending : TOF, read after 'count'
+//
+static uint32_t bus_counts(uint16_t count, uint8_t pending) 
+{
+uint32_t   counts;
+
+    counts = count;
+    if ((pending != 0) && (count < (PWM_COUNT / 2))) {
+        counts += TPM1_PERIOD_COUNTS;
+    }
+    return ((counts << clock_shift) + clock_wraps);
+}
+
+//----------------------------------------------------------------------------
+// init_clock : set the clock to zero
+// ==========
+//
+// Notes
+//      Called during initialisation before interrupts are enabled.
+//
+void init_clock(void) 
+{
+    clock_base_us = 0;
+    clock_wraps = 0;
+    clock_shift = 0;
+}
+
+//----------------------------------------------------------------------------
+// clock_isr : count a TPM1 overflow
+// =========
+//
+// Notes
+//      Called from the TPM1 overflow interrupt.  Reading TPM1SC then
+//      clearing TOF acknowledges the interrupt.
+//
+void clock_isr(void) 
+{
+    (void)TPM1SC;
+    TPM1SC_TOF = 0;
+    clock_base_us += CLOCK_PERIOD_US;
+    if (++clock_wraps == TPM1_COUNTS_PER_US) {
+        clock_wraps = 0;
+        clock_base_us++;
+    }
+}
+
+//----------------------------------------------------------------------------
+// get_time_us : read the microsecond clock
+// ===========
+//
+// Results
+//      microseconds since start-up
+//
+// Notes
+//      Interrupts are not masked.  If the overflow interrupt changes the
+//      base time while it is being read, the read is repeated.  When called
+//      with interrupts masked (e.g. from an ISR) an overflow may be waiting
+//      to be counted.  In that case TOF is set and the count has restarted
+//      from zero, so the period is added here.  Interrupts must not be
+//      masked for more than one period (200uS).  The same is done for the
+//      slow clock in 'menu_idle', where the overflow interrupt is off.
+//
+uint32_t get_time_us(void) 
+{
+uint32_t   base;
+uint16_t   count;
+uint8_t    pending;
+
+    do {
+        base = clock_base_us;
+        count = TPM1CNT;
+        pending = TPM1SC_TOF;
+    } while (base != clock_base_us);
+    if (clock_shift != 0) {
+        return (base + (bus_counts(count, pending) / TPM1_COUNTS_PER_US));
+    }
+    if ((pending != 0) && (count < (PWM_COUNT / 2))) {
+        base += CLOCK_PERIOD_US;
+    }
+    return (base + (count / TPM1_COUNTS_PER_US));
+}
+
+//----------------------------------------------------------------------------
+// set_clock_rate : change the TPM1 prescaler without losing time
+// ==============
+//
+// Parameters
+//      shift : 0 for the bus clock with the overflow interrupt on, or
+//              SLOW_CLOCK_SHIFT for bus clock / 128 with it off
+// Notes
+//      The clock is moved on to the current time, keeping the part uS in
+//      'clock_wraps', and TPM1 restarts from zero.  The prescaler cannot
+//      be read, so when leaving the slow rate this first waits for the
+//      start of a slow count (at most 6.4uS).  The few bus cycles between
+//      reading and restarting the count are lost (under 1uS).
+//
+static void set_clock_rate(uint8_t shift) 
+{
+uint32_t   counts;
+uint16_t   count;
+uint8_t    pending, ccr;
+
+    SAVE_AND_DISABLE_INTERRUPTS(ccr);
+    if (clock_shift != 0) {
+        count = TPM1CNT;
+        while (TPM1CNT == count)         // start of a slow count
+            ;
+    }
+    count = TPM1CNT;
+    pending = TPM1SC_TOF;
+    if (shift == 0) {
+        setReg8(TPM1SC, (TPM_OVFL_INT_EN | TPM_EDGE_ALIGN | TPM_BUSCLK | TPM_PRESCAL_DIV1));
+    } else {
+        setReg8(TPM1SC, (TPM_OVFL_INT_DIS | TPM_EDGE_ALIGN | TPM_BUSCLK | TPM_PRESCAL_DIV128));
+    }
+    TPM1CNT = 0;                         // restart the count and the prescaler
+    (void)TPM1SC;
+    TPM1SC_TOF = 0;
+    counts = bus_counts(count, pending);
+    clock_base_us += counts / TPM1_COUNTS_PER_US;
+    clock_wraps = (uint8_t)(counts % TPM1_COUNTS_PER_US);
+    clock_shift = shift;
+    RESTORE_INTERRUPTS(ccr);
+}
+
+//----------------------------------------------------------------------------
+// menu_idle : sleep in a menu until the next 8mS tick
+// =========
+//
+// Description
+//      While both motors are stopped TPM1 is slowed to bus clock / 128 and
+//      its overflow interrupt turned off, so the CPU is no longer woken
+//      every 200uS.  It still wakes for the RTI and the a/d scan it
+//      starts; wakes before the next tick go straight back to sleep.
+//      TPM1 is at full rate again when this returns, for the motor PWM,
+//      'delay_us' and interrupt timing.
+// Notes
+//      The RTI (8mS, at most 10.4mS) always comes before the slow count
+//      passes half its period (12.8mS), so 'get_time_us' can count the
+//      one overflow that may be waiting.  A braked motor output keeps the
+//      same duty at either rate.
+//
+void menu_idle(void) 
+{
+uint8_t   tick;
+
+    if ((left_motor_state == MOTOR_FORWARD) || (left_motor_state == MOTOR_BACKWARD) ||
+        (right_motor_state == MOTOR_FORWARD) || (right_motor_state == MOTOR_BACKWARD)) {
+        CPU_IDLE;
+        return;
+    }
+    tick = tick_count_8;
+    set_clock_rate(SLOW_CLOCK_SHIFT);
+    do {
+        CPU_IDLE;
+    } while (tick == tick_count_8);
+    set_clock_rate(0);
+}
+
+#ifdef MEASURE_IDLE
+//----------------------------------------------------------------------------
+// Idle time measurement
+// =====================
+//
+// Times are kept in uS and moved into whole seconds as they build up, so
+// the totals do not wrap with the clock.  Time spent in the interrupts that
+// wake the CPU is counted as idle.
+//
+uint32_t    idle_us, awake_us, last_wake_us;
+uint16_t    idle_seconds, awake_seconds;
+
+//----------------------------------------------------------------------------
+// cpu_idle : sleep until the next interrupt, recording the time
+// ========
+//
+// Notes
+//      Used by CPU_IDLE when MEASURE_IDLE is defined.
+//
+void cpu_idle(void) 
+{
+uint32_t   start;
+
+    start = get_time_us();
+    awake_us += start - last_wake_us;
+    CPU_WAIT;
+    last_wake_us = get_time_us();
+    idle_us += last_wake_us - start;
+    while (idle_us >= 1000000) {
+        idle_us -= 1000000;
+        idle_seconds++;
+    }
+    while (awake_us >= 1000000) {
+        awake_us -= 1000000;
+        awake_seconds++;
+    }
+}
+
+//----------------------------------------------------------------------------
+// clear_idle_time : restart the idle time measurement
+// ===============
+//
+void clear_idle_time(void) 
+{
+    idle_us = 0;
+    awake_us = 0;
+    idle_seconds = 0;
+    awake_seconds = 0;
+    last_wake_us = get_time_us();
+}
+#endif /* MEASURE_IDLE */
@@ -0,0 +1,47 @@
+//----------------------------------------------------------------------------
+// clock.h
+// =======
+//
+//----------------------------------------------------------------------------
+//
+#ifndef __clock_H
+#define __clock_H
+
+//
+// TPM1 runs from the bus clock with a modulus of PWM_COUNT, so it wraps
+// every PWM_COUNT + 1 counts.  Each wrap adds CLOCK_PERIOD_US to the
+// clock; the odd count is made up by adding 1uS every
+// TPM1_COUNTS_PER_US wraps.
+//
+#define   TPM1_COUNTS_PER_US    (BUSCLK / 1000000)
+#define   TPM1_PERIOD_COUNTS    (PWM_COUNT + 1)
+#define   CLOCK_PERIOD_US       (PWM_COUNT / TPM1_COUNTS_PER_US)     // 200uS
+//
+// while 'menu_idle' sleeps TPM1 runs from the bus clock / 128 (25.6mS
+// period) with its overflow interrupt off
+//
+#define   SLOW_CLOCK_SHIFT      7
+//
+// TPM1 counts from 'start' to 'now' (two TPM1CNT readings), allowing for
+// at most one wrap of the counter.  Use plain variables as arguments.
+//
+#define   TPM1_ELAPSED(start, now)  \
+    (((now) >= (start)) ? ((now) - (start)) : (((now) + TPM1_PERIOD_COUNTS) - (start)))
+
+#ifdef MEASURE_IDLE
+//
+// time spent idle and awake since 'clear_idle_time' (MEASURE_IDLE is set
+// in user_defines.h)
+//
+extern  uint16_t    idle_seconds, awake_seconds;
+
+void cpu_idle(void);
+void clear_idle_time(void);
+#endif /* MEASURE_IDLE */
+
+void init_clock(void);
+void clock_isr(void);
+uint32_t get_time_us(void);
+void menu_idle(void);
+
+#endif /* __clock_H */
@@ -1,36 +1,73 @@
-
 #include "global.h"
 
+//----------------------------------------------------------------------------
+// Delays are timed with the TPM1 counter (bus clock, 50nS per count) so
+// interrupts only make them end late by the length of the ISR running at
+// the end time, rather than adding up over the delay.  Short delays busy
+// wait on TPM1, longer ones use the microsecond clock and idle the CPU.
+//
+// Non-blocking use :
+//      delay_t   delay;
+//
+//      start_delay(&delay, 500);
+//      while (delay_expired(&delay) == NO) {
+//          ... other work ...
+//      }
+//----------------------------------------------------------------------------
+
 //***********************************************************************
 //** Function:      delay_10us
 //** 
-//** Description:   10uS loop counter delay
+//** Description:   10uS delay timed by TPM1
 //**
 //** Parameters:    None
 //** Returns:       None
 //***********************************************************************  
 void delay_10us(){
-  char n;
-  for (n=0;n<14;n++) {
-    asm("nop");
-    asm("nop");
-  }
+
+    delay_us(10);
 }
 
 //***********************************************************************
 //** Function:      delay_100us
 //** 
-//** Description:   100uS loop counter delay
+//** Description:   100uS delay timed by TPM1
 //**
 //** Parameters:    None
 //** Returns:       None
 //***********************************************************************  
 void delay_100us(){
-  char n;
-  for (n=0;n<141;n++) {
-    asm("nop");
-    asm("nop");
-  }
+
+    delay_us(100);
+}
+
+//----------------------------------------------------------------------------
+// delay_us : busy wait for a number of microseconds
+// ========
+//
+// Parameters
+//      count : number of microseconds 0->MAX_BUSY_DELAY_US
+//
+// Notes
+//      Adds up the TPM1 counts that pass, allowing for the counter
+//      wrapping (see TPM1_ELAPSED).  An ISR longer than one TPM1 period (200uS)
+//      would lose a period.  Does not need interrupts to be enabled.
+// 
+void delay_us(uint16_t count) 
+{
+uint16_t    target, elapsed, last, now;
+
+    if (count > MAX_BUSY_DELAY_US) {
+        count = MAX_BUSY_DELAY_US;
+    }
+    target = count * TPM1_COUNTS_PER_US;
+    elapsed = 0;
+    last = TPM1CNT;
+    while (elapsed < target) {
+        now = TPM1CNT;
+        elapsed += TPM1_ELAPSED(last, now);
+        last = now;
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -41,13 +78,11 @@ void delay_100us(){
 //      none
 //
 // Notes
-//      Uses delay_100us routine
+//      Idles, see 'DelayMs'
 // 
 void delay_1ms(void){
-  char n;
-  for (n=0;n<10;n++) {
-    delay_100us();
-  }
+
+    DelayMs(1);
 }
 
 //----------------------------------------------------------------------------
@@ -58,35 +93,94 @@ void delay_1ms(void){
 //      count : number of millisconds in the delay 0->65,000
 //
 // Notes
-//      Function uses the supplied 'Delay100US' routine
+//      Timed with the microsecond clock, idling the CPU (see 'wait_delay').
+//      Interrupts must be enabled.
 //
 void DelayMs(uint16_t count) 
 {
-uint16_t    i;
+delay_t     delay;
 
     if (count == 0) {
         return;
     }
-    for (i = 0 ; i < count ; i++) {
-        delay_1ms();                   //delay 1 millisecond
-    }
+    start_delay(&delay, count);
+    wait_delay(&delay);
     return;
 }
 
+//----------------------------------------------------------------------------
+// start_delay : start a non-blocking delay
+// ===========
+//
+// Parameters
+//      delay : delay to start
+//      count : number of milliseconds 0->65,000
+//
+void start_delay(delay_t *delay, uint16_t count) 
+{
+    *delay = get_time_us() + ((uint32_t)count * 1000);
+}
+
+//----------------------------------------------------------------------------
+// next_delay : start a delay from the end of the last one
+// ==========
+//
+// Parameters
+//      delay : delay that has expired
+//      count : number of milliseconds 0->65,000
+//
+// Notes
+//      For a series of timed steps.  The time spent starting each step is
+//      not added to its length, so the steps do not drift.
+//
+void next_delay(delay_t *delay, uint16_t count) 
+{
+    *delay += ((uint32_t)count * 1000);
+}
+
+//----------------------------------------------------------------------------
+// delay_expired : test a non-blocking delay
+// =============
+//
+// Results
+//      YES if the delay has ended
+//
+// Notes
+//      Delays up to 35 minutes are handled across the clock wrap.
+//
+uint8_t delay_expired(delay_t *delay) 
+{
+    if ((int32_t)(get_time_us() - *delay) >= 0) {
+        return YES;
+    }
+    return NO;
+}
+
+//----------------------------------------------------------------------------
+// wait_delay : wait for a non-blocking delay to end
+// ==========
+//
+// Notes
+//      Idles until less than one TPM1 period (200uS) is left, so that an
+//      interrupt will still wake the CPU before the end, then busy waits
+//      for the rest.
+//
+void wait_delay(delay_t *delay) 
+{
+    IDLE_WHILE((int32_t)(*delay - get_time_us()) > CLOCK_PERIOD_US);
+    while (delay_expired(delay) == NO) {
+    }
+}
+
 //***********************************************************************
-//** Function:      delay_1ms
+//** Function:      delay_250ms
 //** 
-//** Description:   250ms loop counter delay
+//** Description:   250ms delay (idles, see 'DelayMs')
 //**
 //** Parameters:    None
 //** Returns:       None
 //***********************************************************************  
 void delay_250ms(){
-  char n;
-  for (n=0;n<250;n++) {
-    delay_1ms();
-  }
-}
-
-
 
+    DelayMs(250);
+}
@@ -13,10 +13,19 @@
 #ifndef __delay_H
 #define __delay_H 
 
+#define   MAX_BUSY_DELAY_US   1000     // longest 'delay_us' : use DelayMs above this
+
+typedef uint32_t    delay_t;           // 'get_time_us' value at the end of the delay
+
 void delay_10us(void);
 void delay_100us(void);
+void delay_us(uint16_t count);
 void delay_1ms(void);
 void DelayMs(uint16_t count);
 void delay_250ms(void);
+void start_delay(delay_t *delay, uint16_t count);
+void next_delay(delay_t *delay, uint16_t count);
+uint8_t delay_expired(delay_t *delay);
+void wait_delay(delay_t *delay);
 
-#endif /* __delay_H */
\ No newline at end of file
+#endif /* __delay_H */
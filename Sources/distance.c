@@ -57,6 +57,7 @@ uint8_t   activity;
             set_LED(LED_D, FLASH_ON);
             WAIT_SWITCH_RELEASED(switch_A); 
         } else {
+            MENU_IDLE;      // nothing to do until the next tick
             continue;
         }
 //
@@ -402,9 +403,27 @@ uint8_t     max_left_value, min_left_value, max_right_value, min_right_value;
 //      No speed profile at this time.
 //      
 // Notes
-//
+//      Blocking version built from 'start_move_distance' and
+//      'move_distance_done'.
 //
 uint8_t move_distance(uint16_t encoder_counts, motor_t unit, int8_t l_speed, int8_t r_speed) 
+{
+    start_move_distance(l_speed, r_speed);
+    while (move_distance_done(encoder_counts, unit) == NO) {
+        ;
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// start_move_distance : clear the wheel counters and start both motors
+// ===================
+//
+// Parameters
+//      l_speed        : speed of left motor (-100% -> 100%)
+//      r_speed        : speed of right motor (-100% -> 100%)
+//
+void start_move_distance(int8_t l_speed, int8_t r_speed) 
 {
    //
    // clear encoder wheel counter
@@ -426,27 +445,32 @@ uint8_t move_distance(uint16_t encoder_counts, motor_t unit, int8_t l_speed, int
     } else {
         set_motor(RIGHT_MOTOR, MOTOR_FORWARD, (uint8_t)r_speed); 
     }
+}
+
+//----------------------------------------------------------------------------
+// move_distance_done : check for the end of a distance move
+// ==================
+//
+// Parameters
+//      encoder_counts : number of wheel count
+//      unit           : motor used for wheel encoder counts
 //
-// check if left wheel count has reached, or exceeded specifies encoder count
+// Results
+//      YES if the count has been reached (vehicle is stopped), otherwise NO
 //
+uint8_t move_distance_done(uint16_t encoder_counts, motor_t unit) 
+{
+uint16_t  count;
+
     if (unit == LEFT_MOTOR) {
-        while (left_wheel_count < encoder_counts) {   
-            ;
-        }
-        vehicle_stop();
-        return 0;
+        count = left_wheel_count;
+    } else {
+        count = right_wheel_count;
     }
-//
-// check if right wheel count has reached, or exceeded specifies encoder count
-//    
-    if (unit == RIGHT_MOTOR) {
-        while (right_wheel_count < encoder_counts) {
-            ;
-        }
-        vehicle_stop();
-        return 0;        
+    if (count < encoder_counts) {
+        return NO;
     }
-    
+    vehicle_stop();
+    return YES;
 }
 
-
@@ -12,6 +12,8 @@ uint8_t run_distance_mode_0(void);
 uint8_t run_distance_mode_1(void);
 uint8_t run_distance_mode_2(void);
 uint8_t move_distance(uint16_t encoder_counts, motor_t unit, int8_t l_speed, int8_t r_speed);
+void start_move_distance(int8_t l_speed, int8_t r_speed);
+uint8_t move_distance_done(uint16_t encoder_counts, motor_t unit);
 
 
 #endif /* __distance_H */
\ No newline at end of file
@@ -57,6 +57,7 @@ uint8_t   activity;
             set_LED(LED_D, FLASH_ON);
             WAIT_SWITCH_RELEASED(switch_A); 
         } else {
+            MENU_IDLE;      // nothing to do until the next tick
             continue;
         }
 //
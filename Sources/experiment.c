@@ -18,6 +18,12 @@
 
 extern volatile  uint8_t    flash_test;
 
+#define   EXPERIMENT_CHAR(n)    (((n) < 10) ? ('0' + (n)) : ('A' + (n) - 10))
+
+#ifdef TIME_INTERRUPTS
+static const char  *isr_names[NOS_TIMED_ISRS] = { "IRQ", "KBI", "RTI", "ADC", "TPM1" };
+#endif
+
 
 //----------------------------------------------------------------------------
 // run_experiment_mode : run some experimental code
@@ -35,6 +41,8 @@ extern volatile  uint8_t    flash_test;
 //          6. test flash erase/write
 //          7. Read line sensors and output to serial port
 //          8. serial port echo test ('e' to exit)
+//          9. read switches
+//          A. output interrupt timing to serial port
 //
 //      Active switches are 
 //          switch A = go/stop button
@@ -62,7 +70,7 @@ uint8_t       experiment;
             if (experiment > LAST_EXPERIMENT_MODE) {
                 experiment = FIRST_FOLLOW_MODE;
             }
-            show_dual_chars('E', ('0'+ experiment), (A_TO_FLASH | 10));
+            show_dual_chars('E', EXPERIMENT_CHAR(experiment), (A_TO_FLASH | 10));
         }
         if (switch_C == PRESSED) {            //  back to main 
             WAIT_SWITCH_RELEASED(switch_C);   
@@ -73,12 +81,13 @@ uint8_t       experiment;
             set_LED(LED_D, FLASH_ON);
             WAIT_SWITCH_RELEASED(switch_A); 
         } else {
+            MENU_IDLE;      // nothing to do until the next tick
             continue;
         }
 //
 // run an experiment
 // 
-        show_dual_chars('E', ('0'+ experiment), 0);       
+        show_dual_chars('E', EXPERIMENT_CHAR(experiment), 0);       
         switch (experiment) {
             case CYCLE_DISPLAYS :        // Experiment 0 : Output system version and cycle seven segment and LED displays
                 experiment_0(1);
@@ -109,11 +118,23 @@ uint8_t       experiment;
                 break;   
             case 9 :        // Experiment 9 : read switches
                 experiment_9(1);
+                break;
+            case 10 :       // Experiment A : output interrupt timing
+                experiment_10();
+                break;
+            case 11 :       // Experiment B : dump sensor recorder
+                experiment_11();
+                break;
+            case 12 :       // Experiment C : output idle time
+                experiment_12();
+                break;
+            case 13 :       // Experiment D : measure delay errors under interrupt load
+                experiment_13(20);
                 break;                                                                                                       
              default :
                 break;
         }
-        show_dual_chars('E', ('0'+ experiment), 0); 
+        show_dual_chars('E', EXPERIMENT_CHAR(experiment), 0); 
         E_MODE_LEDS;      
     }      // end of FOREVER loop
 }
@@ -438,5 +459,174 @@ uint8_t   i, j;
     return 0;
 }
 
+//----------------------------------------------------------------------------
+// experiment_10 : output interrupt timing
+// =============
+//
+// Notes
+//      Needs TIME_INTERRUPTS to be defined in user_defines.h.  For each
+//      interrupt vector :
+//          count  min  max  mean  histogram (8 bins of 25.6uS)
+//      then the longest period with interrupts masked.  Times are hex
+//      TPM1 counts (50nS).  Statistics are cleared after the output so
+//      the next run shows the activity since this one.
+//
+uint8_t experiment_10(void) {
+
+#ifdef TIME_INTERRUPTS
+uint8_t        i, j;
+isr_timing_t   entry;
+uint16_t       masked;
+
+    send_msg("ISR timing (hex, 50nS counts)\r\n");
+    send_msg("ISR\tcount\tmin\tmax\tmean\thistogram\r\n");
+    for (i = 0 ; i < NOS_TIMED_ISRS ; i++) {
+        DISABLE_INTERRUPTS;
+        entry = isr_timing[i];
+        ENABLE_INTERRUPTS;
+        send_msg(isr_names[i]); send_msg("\t");
+        send_hex16(entry.count); send_msg("\t");
+        send_hex16(entry.min_time); send_msg("\t");
+        send_hex16(entry.max_time); send_msg("\t");
+        if (entry.count != 0) {
+            send_hex16((uint16_t)(entry.total_time / entry.count));
+        } else {
+            send_hex16(0);
+        }
+        send_msg("\t");
+        for (j = 0 ; j < ISR_TIME_BINS ; j++) {
+            send_hex16(entry.histogram[j]); send_msg(" ");
+        }
+        send_msg("\r\n");
+    }
+    DISABLE_INTERRUPTS;
+    masked = max_masked_time;
+    ENABLE_INTERRUPTS;
+    send_msg("Longest masked\t");
+    send_hex16(masked);
+    send_msg("\r\n");
+    clear_isr_timing();
+#else
+    send_msg("Interrupt timing not enabled\r\n");
+#endif
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// experiment_11 : output the sensor recorder
+// =============
+//
+// Notes
+//      Sends the last RECORDER_SIZE records (see 'recorder.c') as CSV,
+//      oldest first.  Recording stopped when the motors were stopped, so
+//      the output covers the end of the last run.
+//
+uint8_t experiment_11(void) {
+
+    dump_recorder();
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// experiment_12 : output the time the CPU has spent idle
+// =============
+//
+// Notes
+//      Needs MEASURE_IDLE to be defined in user_defines.h.  Shows the
+//      seconds idle and the total seconds since the last run of this
+//      experiment, then restarts the measurement.  To compare power use,
+//      run this experiment, leave the robot in the menus, then run it again.
+//
+uint8_t experiment_12(void) {
+
+#ifdef MEASURE_IDLE
+uint16_t   total, percent;
+
+    total = idle_seconds + awake_seconds;
+    percent = 0;
+    if (total != 0) {
+        percent = (uint16_t)(((uint32_t)idle_seconds * 100) / total);
+    }
+    sprintf(tempstring, "Idle %u of %u s", idle_seconds, total);
+    send_msg(tempstring);
+    sprintf(tempstring, " (%u%%)\r\n", percent);
+    send_msg(tempstring);
+    clear_idle_time();
+#else
+    send_msg("Idle time not measured\r\n");
+#endif
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// experiment_13 : measure delay errors under interrupt load
+// =============
+//
+// Notes
+//      Put the robot on its stand : the motors run at full speed.
+//      Each delay is timed 'count' times with the microsecond clock (TPM1)
+//      while the wheel sensor (IRQ, KBI), RTI, a/d scan, TPM1 and sound
+//      interrupts are all active.  The time taken to read the clock is
+//      measured first and removed.  Output is the nominal time and the
+//      min, mean and max error in uS.
+//
+#define   NOS_DELAY_TESTS     6
+
+static const uint16_t  delay_test_us[NOS_DELAY_TESTS] = {10, 100, 500, 1000, 10000, 50000};
 
+uint8_t experiment_13(uint8_t count) {
+
+uint8_t    i, j;
+uint32_t   start, overhead, taken;
+int16_t    error, min_error, max_error;
+int32_t    total_error;
+
+    enable_wheel_count();
+    set_motor(LEFT_MOTOR, MOTOR_FORWARD, 100);
+    set_motor(RIGHT_MOTOR, MOTOR_FORWARD, 100);
+    play_tune(&snd_beeps_1);
+    DelayMs(1000);                    // let the motors get up to speed
+    
+    overhead = 0xFFFFFFFF;
+    for (j = 0 ; j < count ; j++) {
+        start = get_time_us();
+        taken = get_time_us() - start;
+        if (taken < overhead) {
+            overhead = taken;
+        }
+    }
+    send_msg("Delay errors (uS) : nominal, min, mean, max\r\n");
+    for (i = 0 ; i < NOS_DELAY_TESTS ; i++) {
+        min_error = 32767;
+        max_error = -32767;
+        total_error = 0;
+        for (j = 0 ; j < count ; j++) {
+            start = get_time_us();
+            switch (i) {
+                case 0 :  delay_10us();              break;
+                case 1 :  delay_100us();             break;
+                case 2 :  delay_us(500);             break;
+                case 3 :  delay_1ms();               break;
+                default : DelayMs(delay_test_us[i] / 1000);    break;
+            }
+            taken = get_time_us() - start - overhead;
+            error = (int16_t)(taken - delay_test_us[i]);
+            total_error += error;
+            if (error < min_error) {
+                min_error = error;
+            }
+            if (error > max_error) {
+                max_error = error;
+            }
+        }
+        sprintf(tempstring, "%u, %d, ", delay_test_us[i], min_error);
+        send_msg(tempstring);
+        sprintf(tempstring, "%d, %d\r\n", (int16_t)(total_error / count), max_error);
+        send_msg(tempstring);
+    }
+    vehicle_stop();
+    stop_tune();
+    disable_wheel_count();
+    return 0;
+}
 
@@ -15,5 +15,9 @@ uint8_t experiment_6(void);
 uint8_t experiment_7(uint8_t count);
 uint8_t experiment_8(void);
 uint8_t experiment_9(uint8_t count);
+uint8_t experiment_10(void);
+uint8_t experiment_11(void);
+uint8_t experiment_12(void);
+uint8_t experiment_13(uint8_t count);
 
 #endif
\ No newline at end of file
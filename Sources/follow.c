@@ -57,6 +57,7 @@ uint8_t     activity;
             set_LED(LED_D, FLASH_ON);
             WAIT_SWITCH_RELEASED(switch_A); 
         } else {
+            MENU_IDLE;      // nothing to do until the next tick
             continue;
         }
 //
@@ -109,9 +110,10 @@ uint8_t     activity;
 
 uint8_t run_follow_line_mode(void) {
 
-uint8_t       line_L, line_R, ad_value, drag_speed;
-uint16_t      sample_time, temp16;
-mode_state_t  state;
+uint8_t         line_L, line_R, ad_value, drag_speed;
+uint16_t        sample_time, temp16;
+mode_state_t    state;
+switch_event_t  event;
 
     state = MODE_INIT;
     left_speed = DEFAULT_LINE_FOLLOW_SPEED;
@@ -122,17 +124,19 @@ mode_state_t  state;
     set_LED(LED_B, FLASH_ON);
     set_LED(LED_C, FLASH_ON);
     clr_LED(LED_D);    
+    flush_switch_events();
 //
 // main loop
 //       
     FOREVER {
 //
-//  run simple state machine to define operating modes
-//  There are two states : MODE_INIT and MODE_RUNNING
+// read pots to set system characteristics.  Switch B is taken from the
+// event queue so the line is still followed while it is held down.
 //
-// read pots to set system characteristics
-//
-        if (switch_B == PRESSED) {
+        while (get_switch_event(&event) == YES) {
+            if ((event.switch_bit != SWITCH_B_BIT) || (event.type != SW_EVENT_PRESS)) {
+                continue;
+            }
             SOUND_READ_POTS;  
 
             ad_value = get_adc(POT_1);
@@ -153,8 +157,6 @@ mode_state_t  state;
             if (sample_time == 0) {              // ensure that sample time is not 0
                 sample_time = 10;
             }
-    
-            WAIT_SWITCH_RELEASED(switch_B);
         }
 //
 //  check for exit
@@ -244,17 +246,22 @@ mode_state_t  state;
 //          switch C = exit mode
 //
 //      Active pots
-//          POT_1 : ambient light setting   0->63
-//          POT_2 : drag speed setting   (if switch B is pressed for less than 2 seconds)
-//          POT_2 : deadband 0->15       (if switch B is pressed for more than 2 seconds)
+//          POT_1 : ambient light setting   0->63  (if switch B is pressed for less than 2 seconds)
+//          POT_1 : deadband 0->15.75 in steps of 0.25  (if switch B is pressed for more than 2 seconds)
+//          POT_2 : drag speed setting
 //          POT_3 : sample rate   -  0->200mS
 //
+//      Light sensors are read with 10-bit resolution so light levels, ambient
+//      and deadband are all held in 10-bit units (4 x 8-bit value).
+//
 uint8_t run_follow_light_mode(void) {
 
-uint8_t       ad_value, light_L, light_R, ambient_L, ambient_R, ambient_diff, larger_reading, light_diff;
-uint8_t       light_deadband, light_average, sample_time, drag_speed, ambient;
-int16_t       temp16, ticks;
-mode_state_t  state;
+uint8_t         ad_value, larger_reading, sample_time, drag_speed;
+uint16_t        light_L, light_R, ambient_L, ambient_R, ambient_diff, light_diff;
+uint16_t        light_deadband, light_average, ambient;
+int16_t         temp16;
+mode_state_t    state;
+switch_event_t  event;
 
     state = MODE_INIT;
     left_speed = SLOW_SPEED;
@@ -262,8 +269,8 @@ mode_state_t  state;
     drag_speed = 0;
     sample_time = DEFAULT_SAMPLE_TIME;
     
-    light_deadband = DEFAULT_DEADBAND;
-    ambient = DEFAULT_AMBIENT;
+    light_deadband = DEFAULT_DEADBAND << 2;       // 10-bit units
+    ambient = DEFAULT_AMBIENT << 2;
 
     set_LED(LED_A, FLASH_ON);
     set_LED(LED_B, FLASH_ON);
@@ -272,31 +279,36 @@ mode_state_t  state;
 //
 // read sensors to get ambient light values and comput the difference
 //
-    ambient_L = get_adc(FRONT_SENSOR_L);  
-    ambient_R = get_adc(FRONT_SENSOR_R);
+    ambient_L = get_adc10(FRONT_SENSOR_L);  
+    ambient_R = get_adc10(FRONT_SENSOR_R);
     if (ambient_L > ambient_R) {
         ambient_diff = ambient_L - ambient_R;
     } else {
         ambient_diff = ambient_R - ambient_L;
     }
+    flush_switch_events();
 //
 // main loop
 //       
     FOREVER {
 //
-// read pots to set system characteristics
+// read pots to set system characteristics when switch B is released.  Switch B 
+// is taken from the event queue so the light is still followed while it is held down.
 //    
-        if (switch_B == PRESSED) {
-            CLR_TIMER16;
-            SOUND_READ_POTS;
-            WAIT_SWITCH_RELEASED(switch_B);     // wait until button returns to quiescent state 
-            GET_TIMER16(ticks);                 // read 16-bit 8mS tick counter
-            
-            ad_value = get_adc(POT_1);                     
-            if (ticks > (2 * TICKS_IN_ONE_SECOND)) {          // button press time > 2 seconds
-                light_deadband =  ((ad_value >> 4) & 0x0F);       // convert to 0->15 
+        while (get_switch_event(&event) == YES) {
+            if (event.switch_bit != SWITCH_B_BIT) {
+                continue;
+            }
+            if (event.type == SW_EVENT_PRESS) {
+                SOUND_READ_POTS;
+            }
+            if (event.type != SW_EVENT_RELEASE) {
+                continue;
+            }
+            if (event.duration > (2 * TICKS_IN_ONE_SECOND)) {  // button press time > 2 seconds
+                light_deadband = get_adc10(POT_1) >> 4;           // convert to 0->63 (10-bit units)
             } else {
-                ambient =  ((ad_value >> 2) & 0x3F);              // convert to 0->63 
+                ambient = get_adc10(POT_1) >> 2;                  // convert to 0->255 (0->63.75 in 8-bit units)
             }            
             ad_value = get_adc(POT_2);
             temp16 =  ((ad_value >> 3) & 0x1F);                   // convert to 0->31
@@ -313,8 +325,8 @@ mode_state_t  state;
             //
             // recalculate ambient
             //
-            ambient_L = get_adc(FRONT_SENSOR_L);  
-            ambient_R = get_adc(FRONT_SENSOR_R);
+            ambient_L = get_adc10(FRONT_SENSOR_L);  
+            ambient_R = get_adc10(FRONT_SENSOR_R);
             if (ambient_L > ambient_R) {
                 ambient_diff = ambient_L - ambient_R;
             } else {
@@ -351,10 +363,10 @@ mode_state_t  state;
             }
         } 
 //
-// read light sensors and correct for ambient.  Add 20 to keep value away from zero.
+// read light sensors (10-bit) and correct for ambient.  Add 80 to keep value away from zero.
 //
-        light_L = (ambient_L + 20) - (get_adc(FRONT_SENSOR_L));  
-        light_R = (ambient_R + 20) - (get_adc(FRONT_SENSOR_R));
+        light_L = (ambient_L + 80) - (get_adc10(FRONT_SENSOR_L));  
+        light_R = (ambient_R + 80) - (get_adc10(FRONT_SENSOR_R));
         light_average = (light_R / 2) + (light_L /2); 
         if (light_L > light_R) {
             light_diff = light_L - light_R;
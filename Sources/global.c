@@ -161,20 +161,12 @@ seven_seg_display_t  zero_display = {
 //----------------------------------------------------------------------------
 // test sequence  : move forward for 2 seconds.
 //
-uint16_t  program_a[50] = {
-
-    INSTRUCTION(PUSH_L8,        IMMEDIATE,  40              ), 
-    INSTRUCTION(PUSH_L8,        IMMEDIATE,  MOTOR_FORWARD   ),
-    INSTRUCTION(PUSH_L8,        IMMEDIATE,  LEFT_MOTOR      ),
-    INSTRUCTION(SET_PARAMETER,  NO_MOD,     SPEED           ),
-    INSTRUCTION(PUSH_L8,        IMMEDIATE,  40              ), 
-    INSTRUCTION(PUSH_L8,        IMMEDIATE,  MOTOR_FORWARD   ),
-    INSTRUCTION(PUSH_L8,        IMMEDIATE,  RIGHT_MOTOR     ),
-    INSTRUCTION(SET_PARAMETER,  NO_MOD,     SPEED           ),
-    INSTRUCTION(EXECUTE,        NO_MOD,     START           ),
-    INSTRUCTION(DELAY,          IMMEDIATE,  20              ),
-    INSTRUCTION(EXECUTE,        NO_MOD,     STOP            ),
+const uint16_t  program_a[] = {
+
+    INSTRUCTION(SET_SPEEDS,     DRIVE_FORWARD,  40          ),
+    INSTRUCTION(TIMED_MOVE,     NO_MOD,     20              ),
     INSTRUCTION(EXIT,           NO_MOD,     NO_DATA         ),
+    END_OF_SEQUENCE
 };
 
 //
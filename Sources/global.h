@@ -36,6 +36,10 @@
 #include "lab.h"
 #include "distance.h"
 #include "interpreter.h"
+#include "optimise.h"
+#include "recorder.h"
+#include "timer.h"
+#include "clock.h"
 //
 //
 //
@@ -60,9 +64,9 @@ extern  uint8_t          left_motor_tweak, right_motor_tweak;
 extern  uint16_t    tick_count_16;
 extern  uint8_t     tick_count_8; 
 extern  uint8_t     second_count;   
-extern  uint8_t     tick_for_second_count;
 
 extern  uint8_t     debounced_state;    // switch debounce variables
+extern  uint8_t     switch_press_edges, switch_release_edges;
 extern  uint8_t     switch_A, switch_B, switch_C, switch_D, switch_ABCD;
 
 extern  uint16_t    left_wheel_count, right_wheel_count;
@@ -70,8 +74,6 @@ extern  uint8_t     LED_image, display_image, swap_image, LED_flash_map, display
 
 extern  uint16_t    left_wheel_count, right_wheel_count;
 extern  uint8_t     left_wheel_sensor_value, right_wheel_sensor_value;
-extern  uint8_t     left_speed_index, right_speed_index;
-extern  uint16_t    left_speed_array[64], right_speed_array[64];
 
 
 
@@ -119,10 +121,11 @@ extern const sound_file_t   snd_system_init;
 extern const sound_file_t   snd_battery_low;
 extern const sound_file_t   snd_battery_recharge;
 extern const sound_file_t   snd_bump;
+extern const sound_file_t   snd_fault;
 
 extern  seven_seg_display_t  zero_display;
 
-extern uint16_t  program_a[50];
+extern const uint16_t  program_a[];
 
 extern struct  {
     uint8_t     op_code;
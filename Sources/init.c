@@ -215,7 +215,9 @@ void Init_sci(void)
 //      1. enable appropriate analogue input pins
 //      2. software trigger, disable compare function
 //      3. high speed, clock div 8, short sample, 8-bit conversion and 20MHz busclock input
+//         (10-bit for the channels that need it, see adc.c)
 //      4. disable interrupt, single convert mode, set disable channel input
+//      5. fill the background scan data (see adc.c)
 //
 void Init_adc(void)
 {
@@ -225,9 +227,11 @@ void Init_adc(void)
 //
     setReg8(ADC1SC2, (AD_CONV_TRIG_SOFT | AD_COMP_FUNC_DIS | AD_COMP_GT_DIS));                      // 0x00   
 //
-    setReg8(ADC1CFG, (AD_HS_EN | AD_CLK_DIV_8 | AD_SHORT_SAMPL | AD_CONV_8BIT | AD_CLK_BUSCLK));    // 0x03
+    setReg8(ADC1CFG, ADC_CFG_8BIT);        // 0x60 : scan switches to 10-bit for some channels
 //                                          
     setReg8(ADC1SC1, (AD_INT_DIS | AD_SING_CONV | AD_CHAN_DIS));                                    // 0x1F 
+//
+    adc_scan_init();
 }
 
 //----------------------------------------------------------------------------
@@ -258,7 +262,7 @@ void Init_pwm(void){
     setReg8(TPM1C2SC, (TPM_INT_DIS | PWM_EDGE_ALIGNED | PWM_ACT_HIGH_PULSE));
     setReg8(TPM1C3SC, (TPM_INT_DIS | PWM_EDGE_ALIGNED | PWM_ACT_HIGH_PULSE));
                    
-    setReg8(TPM1SC, (TPM_OVFL_INT_DIS | TPM_EDGE_ALIGN | TPM_BUSCLK | TPM_PRESCAL_DIV1));   
+    setReg8(TPM1SC, (TPM_OVFL_INT_EN | TPM_EDGE_ALIGN | TPM_BUSCLK | TPM_PRESCAL_DIV1));    // overflow drives 'get_time_us'
 //
 // init of channel 2 : PWM signals for system buzzer
 //   
@@ -14,32 +14,94 @@
 
 #include "global.h"
 
-#define    STACK_SIZE        8         // number of 16-bit elements oon the stack
 #define    NOS_VARIABLES    16
+#define    NOS_LOCAL_VARIABLES  12    // V0-V11 private to each sequence, V12-V15 shared
+#define    RETURN_STACK_SIZE 4        // maximum nesting of CALL instructions
+
+enum { WAIT_NONE, WAIT_DELAY, WAIT_MOVE_TIME, WAIT_MOVE_DISTANCE,
+       WAIT_ON_SENSOR, WAIT_ON_WHEEL, WAIT_ON_SWITCH_PRESS, WAIT_ON_SWITCH_RELEASE };
 
 //
-// stack to hold data for the robot commands
+// instruction handlers : one per op-code/modifier combination
 //
-union {
-    uint16_t item_16[STACK_SIZE];
-    uint8_t  item_8[STACK_SIZE*2];
-} stack;
+typedef enum {
+    H_NOP,
+    H_PUSH_16_IMM, H_PUSH_16_REG,
+    H_PUSH_L8_IMM, H_PUSH_L8_REG,
+    H_PUSH_H8_IMM, H_PUSH_H8_REG,
+    H_POP_8,       H_POP_16,
+    H_SET_SPEED,   H_SET_DISTANCE, H_SET_TIME,
+    H_ADD,
+    H_GOTO,
+    H_DEC_AND_SKIP,
+    H_MOVE_TIME,   H_MOVE_DISTANCE, H_START, H_STOP,
+    H_TEST_EQ,     H_TEST_LT,       H_TEST_GT,
+    H_READ_CHAN_IMM, H_READ_CHAN_STK,
+    H_DELAY_IMM,   H_DELAY_STK,
+    H_DRIVE_FORWARD, H_DRIVE_SPIN_LEFT, H_DRIVE_SPIN_RIGHT, H_DRIVE_BACKWARD,
+    H_TIMED_MOVE,  H_DISTANCE_MOVE,
+    H_CALL,        H_RET,
+    H_WAIT_UNTIL_EQ, H_WAIT_UNTIL_LT, H_WAIT_UNTIL_GT,
+    H_WAIT_WHEEL_LEFT, H_WAIT_WHEEL_RIGHT,
+    H_WAIT_SWITCH,
+    H_EXIT,
+    H_INVALID,
+    NOS_HANDLERS
+} handler_t;
+
+#define    UNVISITED        0xFF      // verifier : instruction not yet reached
+
+static void run_started_sequence(uint8_t start_status);
+
 //
-// stack machine registers
+// state of one running sequence
 //
-uint8_t    stack_ptr = 0;       // stack pointer
-uint16_t   sequence_ptr = 0;    // program counter
+typedef struct {
+    uint16_t   stack[STACK_SIZE];                 // data stack
+    uint16_t   vars[NOS_LOCAL_VARIABLES];         // V0 to V11
+    uint8_t    return_stack[RETURN_STACK_SIZE];   // return addresses for CALL/RET
+    uint8_t    stack_ptr;
+    uint8_t    return_ptr;
+    uint8_t    sequence_ptr;                      // program counter
+    uint8_t    code_base, code_end;               // part of 'decoded_sequence' holding the code
+    uint8_t    running;
+    uint8_t    wait, wait_unit, wait_cmp;         // motion/delay/event being waited on
+    uint16_t   wait_start, wait_target;
+    uint8_t    left_speed, right_speed, left_direction, right_direction;
+    uint16_t   time, distance;
+} seq_context_t;
+
+seq_context_t   contexts[MAX_SEQUENCES];
+seq_context_t   *ctx;                   // context of the sequence being stepped
+uint8_t         nos_contexts;           // number of sequences loaded
+uint8_t         next_context;           // round-robin position
 //
-// storage for variables
+// variables shared by all sequences (V12 to V15)
 //
-uint16_t vars[NOS_VARIABLES];
+uint16_t        shared_vars[NOS_VARIABLES - NOS_LOCAL_VARIABLES];
 
 //
-// parameters relevant to the currently executing program
+// instruction mnemonics for sequence dumps : order MUST match 'instruction_t'
 //
-uint8_t   sequence_left_speed, sequence_right_speed, sequence_left_direction, sequence_right_direction;
-uint16_t  sequence_time, sequence_distance;
+const char * const inst_names[NOS_INSTRUCTIONS] = {
+    "PUSH_16", "PUSH_L8", "PUSH_H8", "POP_8", "POP_16", "SET_PARAMETER",
+    "COMPUTE", "GOTO", "EXECUTE", "DEC_AND_SKIP", "TEST_AND_SKIP", "READ_CHAN", "EXIT", "DELAY",
+    "SET_SPEEDS", "TIMED_MOVE", "DISTANCE_MOVE", "CALL", "RET",
+    "WAIT_UNTIL", "WAIT_WHEEL_COUNT", "WAIT_SWITCH",
+};
 
+//
+// pre-decoded copy of the sequences being run : each sequence uses the
+// entries from its 'code_base' to 'code_end'
+//
+decoded_inst_t  decoded_sequence[RAM_SEQUENCE_SIZE];
+uint8_t         code_free;              // first unused entry
+//
+// verifier working data
+//
+uint8_t         verify_depth[RAM_SEQUENCE_SIZE];
+uint8_t         verify_changed, sequence_max_depth, verify_call_depth;
+uint8_t         verify_base, verify_end;
 
     
 //----------------------------------------------------------------------------
@@ -47,30 +109,71 @@ uint16_t  sequence_time, sequence_distance;
 // ==========================
 //
 // Description
-//      Set all relevant variables to theit init state.
+//      Remove all loaded sequences and clear the shared variables.
 // Parameters
 //      None
 // Globals      
-//      stack, vars,stack_ptr,sequence_ptr 
+//      contexts, nos_contexts, code_free, shared_vars
 //
 void init_for_sequence_execution(void) 
 {
-int i;
+uint8_t i;
   
-    stack_ptr = 0;
-    sequence_ptr = 0;
-    sequence_left_speed = 0;
-    sequence_right_speed= 0;
-    sequence_time = 0;
-    sequence_distance = 0;
-    
-    for (i=0 ; i<NOS_VARIABLES ; i++) {
-        vars[i] = 0;
+    for (i=0 ; i<MAX_SEQUENCES ; i++) {
+        contexts[i].running = NO;
     }
+    nos_contexts = 0;
+    next_context = 0;
+    code_free = 0;
+    ctx = &contexts[0];
+    for (i=0 ; i<(NOS_VARIABLES - NOS_LOCAL_VARIABLES) ; i++) {
+        shared_vars[i] = 0;
+    }
+}
+
+//----------------------------------------------------------------------------
+// init_context : reset a sequence context ready to run its code
+// ============
+//
+static void init_context(seq_context_t *context, uint8_t base, uint8_t length) 
+{
+uint8_t i;
 
+    context->stack_ptr = 0;
+    context->return_ptr = 0;
+    context->sequence_ptr = base;
+    context->code_base = base;
+    context->code_end = base + length;
+    context->wait = WAIT_NONE;
+    context->left_speed = 0;
+    context->right_speed = 0;
+    context->left_direction = MOTOR_OFF;
+    context->right_direction = MOTOR_OFF;
+    context->time = 0;
+    context->distance = 0;
+    for (i=0 ; i<NOS_LOCAL_VARIABLES ; i++) {
+        context->vars[i] = 0;
+    }
     for (i=0 ; i<STACK_SIZE ; i++) {
-        stack.item_16[i] = 0;
+        context->stack[i] = 0;
+    }
+    context->running = YES;
+}
+
+//----------------------------------------------------------------------------
+// var_address : find the storage for a variable
+// ===========
+//
+// Results
+//      address of a local variable of the current sequence, or of a shared
+//      variable
+//
+static uint16_t *var_address(uint8_t var) 
+{
+    if (var < NOS_LOCAL_VARIABLES) {
+        return &ctx->vars[var];
     }
+    return &shared_vars[var - NOS_LOCAL_VARIABLES];
 }
 
 //----------------------------------------------------------------------------
@@ -83,15 +186,14 @@ int i;
 // Parameters
 //      value   : 8-bit value to be stored on the stack
 // Globals      
-//      stack : stack structure in RAM
+//      ctx : context of the sequence being run
 // Notes
 //      On entry, stack pointer points to the empty top of the stack
 //
 void cmd_push_L8(uint8_t value) 
 {  
-    stack.item_16[stack_ptr] = 0;
-    stack.item_8[(stack_ptr *2) + 1] = value;
-    stack_ptr++;    
+    ctx->stack[ctx->stack_ptr] = value;
+    ctx->stack_ptr++;    
 }
 
 //----------------------------------------------------------------------------
@@ -104,7 +206,7 @@ void cmd_push_L8(uint8_t value)
 // Parameters
 //      value   : 8-bit value to be stored on the stack
 // Globals      
-//      stack : stack structure in RAM
+//      ctx : context of the sequence being run
 // Notes
 //      On entry, stack pointer points to the empty top of the stack but value
 //      is stored in the previous stack element.
@@ -112,8 +214,7 @@ void cmd_push_L8(uint8_t value)
 //
 void cmd_push_H8(uint8_t value) 
 {  
-
-    stack.item_8[(stack_ptr * 2) -2] = value;  
+    ctx->stack[ctx->stack_ptr - 1] = (ctx->stack[ctx->stack_ptr - 1] & 0x00FF) | ((uint16_t)value << 8);
 }
 
 //----------------------------------------------------------------------------
@@ -125,15 +226,15 @@ void cmd_push_H8(uint8_t value)
 // Parameters
 //      value   : 16-bit value to be stored on the stack
 // Globals      
-//      stack : stack structure in RAM
+//      ctx : context of the sequence being run
 // Notes
 //      On entry, stack pointer points to the empty top of the stack
 //
 void cmd_push_16(uint16_t value) 
 {  
 
-    stack.item_16[stack_ptr] = value;
-    stack_ptr++;    
+    ctx->stack[ctx->stack_ptr] = value;
+    ctx->stack_ptr++;    
 }
 
 //----------------------------------------------------------------------------
@@ -147,12 +248,14 @@ void cmd_push_16(uint16_t value)
 // Results
 //      returns an 8-bit value
 // Globals      
-//      stack : stack structure in RAM
+//      ctx : context of the sequence being run
+// Notes
+//      Returns the low byte of the element (the one written by push_L8)
 //
 uint8_t cmd_pop_8(void) 
 {  
-    stack_ptr--;    
-    return (stack.item_8[stack_ptr * 2]);
+    ctx->stack_ptr--;    
+    return ((uint8_t)ctx->stack[ctx->stack_ptr]);
 }
 
 //----------------------------------------------------------------------------
@@ -166,12 +269,12 @@ uint8_t cmd_pop_8(void)
 // Results
 //      returns a 16-bit value
 // Globals      
-//      stack : stack structure in RAM
+//      ctx : context of the sequence being run
 //
 uint16_t cmd_pop_16(void) 
 {  
-    stack_ptr--;    
-    return (stack.item_16[stack_ptr]);
+    ctx->stack_ptr--;    
+    return (ctx->stack[ctx->stack_ptr]);
 }
 
 //----------------------------------------------------------------------------
@@ -190,31 +293,1036 @@ void decode_command(uint16_t command)
 {
     
     robot_command.op_code  = (uint8_t)((command >> 8) & 0x3F);
-    robot_command.modifier = (uint8_t)((command >> 8) & 0xC0);
+    robot_command.modifier = (uint8_t)((command >> 14) & 0x03);
     robot_command.data     = (uint8_t)((command) & 0xFF);
 }
 
 //----------------------------------------------------------------------------
-// run_sequence : run a sequence of robot commands
-// ============
+// pack_instruction : convert an instruction to the compact FLASH encoding
+// ================
 //
 // Description
-//      Execute a specified sequence of robot command.
+//      Instructions with no modifier and data of 0 to 3 (EXIT, RET,
+//      COMPUTE ADD, EXECUTE xxx, SET_PARAMETER xxx, TEST_AND_SKIP xxx,
+//      POP_16 V0..V3, ...) are stored in one byte
+//
+//          bit 7-6 = data, bit 5 = 1, bit 4-0 = op-code
+//
+//      all others take two bytes, the high then low byte of the 16-bit
+//      instruction (bit 5 of the first byte is always 0).  A first byte of
+//      PACKED_END (0xFF, erased FLASH) marks the end of a sequence.
 // Parameters
-//      program : array of instructions
+//      command : 16-bit instruction
+//      packed  : 2-byte buffer for the result
 // Results
-//      None
+//      number of bytes used (1 or 2), 0 if the instruction cannot be
+//      packed (e.g. an unused 0xFFFF entry)
+//
+uint8_t pack_instruction(uint16_t command, uint8_t packed[]) 
+{
+    if (INST_OP_CODE(command) >= PACKED_MAX_OP_CODE) {
+        return 0;
+    }
+    if ((INST_MODIFIER(command) == 0) && (INST_DATA(command) <= 3)) {
+        packed[0] = (uint8_t)((INST_DATA(command) << 6) | PACKED_SHORT | INST_OP_CODE(command));
+        return 1;
+    }
+    packed[0] = (uint8_t)(command >> 8);
+    packed[1] = (uint8_t)command;
+    return 2;
+}
+
+//----------------------------------------------------------------------------
+// unpack_instruction : convert compact FLASH encoding back to an instruction
+// ==================
+//
+// Parameters
+//      packed  : packed bytes (first byte must not be PACKED_END)
+//      command : returned 16-bit instruction
+// Results
+//      number of bytes used (1 or 2)
+//
+uint8_t unpack_instruction(const uint8_t packed[], uint16_t *command) 
+{
+    if (packed[0] & PACKED_SHORT) {
+        *command = INSTRUCTION(packed[0] & 0x1F, NO_MOD, packed[0] >> 6);
+        return 1;
+    }
+    *command = ((uint16_t)packed[0] << 8) | packed[1];
+    return 2;
+}
+
+//----------------------------------------------------------------------------
+// start_wait : suspend the sequence until a motion, delay or event completes
+// ==========
+//
+// Parameters
+//      type   : WAIT_xxx
+//      target : number of 8mS ticks, wheel encoder counts or a/d threshold
+//
+// Notes
+//      Times are measured from a snapshot of 'tick_count_16' so the shared
+//      counter is never cleared by a running sequence.
 //
-void run_sequence(uint16_t  sequence[]) 
+static void start_wait(uint8_t type, uint16_t target) 
+{
+    GET_TIMER16(ctx->wait_start);
+    ctx->wait_target = target;
+    ctx->wait = type;
+}
+
+//----------------------------------------------------------------------------
+// read_wheel_count : read a wheel encoder count updated by the RTI
+// ================
+//
+static uint16_t read_wheel_count(uint8_t unit) 
+{
+uint16_t  count;
+
+    DISABLE_INTERRUPTS;
+    if (unit == LEFT_MOTOR) {
+        count = left_wheel_count;
+    } else {
+        count = right_wheel_count;
+    }
+    ENABLE_INTERRUPTS;
+    return count;
+}
+
+//----------------------------------------------------------------------------
+// read_switch : read the debounced state of switch B, C or D
+// ===========
+//
+static uint8_t read_switch(uint8_t unit) 
+{
+    switch (unit) {
+        case SW_B : return switch_B;
+        case SW_C : return switch_C;
+        default   : return switch_D;
+    }
+}
+
+//----------------------------------------------------------------------------
+// wait_complete : check if the current motion, delay or event has completed
+// =============
+//
+// Results
+//      YES if the sequence can continue, otherwise NO
+//
+static uint8_t wait_complete(void) 
+{
+uint16_t  time, value;
+
+    switch (ctx->wait) {
+        case WAIT_DELAY :
+        case WAIT_MOVE_TIME :
+            GET_TIMER16(time);
+            if ((uint16_t)(time - ctx->wait_start) <= ctx->wait_target) {
+                return NO;
+            }
+            if (ctx->wait == WAIT_MOVE_TIME) {
+                vehicle_stop();
+            }
+            break;
+        case WAIT_MOVE_DISTANCE :
+            if (move_distance_done(ctx->wait_target, ctx->wait_unit) == NO) {
+                return NO;
+            }
+            break;
+        case WAIT_ON_SENSOR :
+            value = get_adc(ctx->wait_unit);
+            switch (ctx->wait_cmp) {
+                case EQ : if (value != ctx->wait_target)  { return NO; } break;
+                case LT : if (value >= ctx->wait_target)  { return NO; } break;
+                default : if (value <= ctx->wait_target)  { return NO; } break;
+            }
+            break;
+        case WAIT_ON_WHEEL :
+            value = read_wheel_count(ctx->wait_unit) - ctx->wait_start;
+            if (value < ctx->wait_target) {
+                return NO;
+            }
+            break;
+        case WAIT_ON_SWITCH_PRESS :
+            if (read_switch(ctx->wait_unit) != PRESSED) {
+                return NO;
+            }
+            ctx->wait = WAIT_ON_SWITCH_RELEASE;
+            return NO;
+        case WAIT_ON_SWITCH_RELEASE :
+            if (read_switch(ctx->wait_unit) == PRESSED) {
+                return NO;
+            }
+            break;
+        default :
+            break;
+    }
+    ctx->wait = WAIT_NONE;
+    return YES;
+}
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+// Instruction handlers
+// ====================
+//
+// One routine per op-code/modifier combination.  Each handler is entered
+// with 'ctx->sequence_ptr' already pointing at the following instruction.
+//
+static void op_nop(const decoded_inst_t *inst) 
+{
+}
+
+static void op_push_16_imm(const decoded_inst_t *inst) 
+{
+    cmd_push_L8(inst->data);
+}
+
+static void op_push_16_reg(const decoded_inst_t *inst) 
+{
+    cmd_push_16(*var_address(inst->data));
+}
+
+static void op_push_L8_imm(const decoded_inst_t *inst) 
+{
+    cmd_push_L8(inst->data);
+}
+
+static void op_push_L8_reg(const decoded_inst_t *inst) 
+{
+    cmd_push_L8((uint8_t)*var_address(inst->data));
+}
+
+static void op_push_H8_imm(const decoded_inst_t *inst) 
+{
+    cmd_push_H8(inst->data);
+}
+
+static void op_push_H8_reg(const decoded_inst_t *inst) 
+{
+    cmd_push_H8((uint8_t)*var_address(inst->data));
+}
+
+static void op_pop_8(const decoded_inst_t *inst) 
+{
+    *var_address(inst->data) = cmd_pop_8();
+}
+
+static void op_pop_16(const decoded_inst_t *inst) 
+{
+    *var_address(inst->data) = cmd_pop_16();
+}
+
+static void op_set_speed(const decoded_inst_t *inst) 
+{
+    if (cmd_pop_16() == LEFT_MOTOR) {
+        ctx->left_direction = cmd_pop_16();
+        ctx->left_speed = cmd_pop_16() + left_motor_tweak;
+    } else {
+        ctx->right_direction = cmd_pop_16();
+        ctx->right_speed = cmd_pop_16() + right_motor_tweak; 
+    }   
+}
+
+static void op_set_distance(const decoded_inst_t *inst) 
+{
+    ctx->distance = cmd_pop_16();
+}
+
+static void op_set_time(const decoded_inst_t *inst) 
+{
+    ctx->time = cmd_pop_16();
+}
+
+static void op_add(const decoded_inst_t *inst) 
+{
+    ctx->stack[ctx->stack_ptr-2] = ctx->stack[ctx->stack_ptr-1] + ctx->stack[ctx->stack_ptr-2];
+    ctx->stack_ptr--;
+}
+
+static void op_goto(const decoded_inst_t *inst) 
+{
+    ctx->sequence_ptr = inst->data;              // absolute target resolved at load time
+}
+
+static void op_dec_and_skip(const decoded_inst_t *inst) 
+{
+uint16_t  *var;
+
+    var = var_address(inst->data);
+    (*var)--;
+    if (*var == 0) {
+        ctx->sequence_ptr++;
+    }
+}
+
+static void op_move_time(const decoded_inst_t *inst) 
+{
+    set_motor(LEFT_MOTOR, ctx->left_direction, ctx->left_speed);
+    set_motor(RIGHT_MOTOR, ctx->right_direction, ctx->right_speed);
+    start_wait(WAIT_MOVE_TIME, ctx->time);
+}
+
+static void op_move_distance(const decoded_inst_t *inst) 
 {
 int8_t   r_speed, l_speed;
-uint8_t  motor, ad_value, speed_tweak;
-uint16_t time, target_time;
 
-    init_for_sequence_execution();
+    if (ctx->left_direction == MOTOR_BACKWARD) {
+        l_speed = -(int8_t)ctx->left_speed;
+    } else {
+        l_speed = (int8_t)ctx->left_speed;
+    }
+    if (ctx->right_direction == MOTOR_BACKWARD) {
+        r_speed = -(int8_t)ctx->right_speed;
+    } else {
+        r_speed = (int8_t)ctx->right_speed;
+    }
+    if (ctx->left_speed > ctx->right_speed) {
+        ctx->wait_unit = LEFT_MOTOR; 
+    } else {
+        ctx->wait_unit = RIGHT_MOTOR;
+    }
+    start_move_distance(l_speed, r_speed);
+    start_wait(WAIT_MOVE_DISTANCE, ctx->distance);
+}
+
+static void op_start(const decoded_inst_t *inst) 
+{
+    set_motor(LEFT_MOTOR, ctx->left_direction, ctx->left_speed);
+    set_motor(RIGHT_MOTOR, ctx->right_direction, ctx->right_speed);
+}
+
+static void op_stop(const decoded_inst_t *inst) 
+{
+    vehicle_stop();
+}
+
+static void op_test_eq(const decoded_inst_t *inst) 
+{
+    if (ctx->stack[ctx->stack_ptr-1] == ctx->stack[ctx->stack_ptr-2]){
+        ctx->sequence_ptr++;
+    }
+    ctx->stack_ptr -= 2;      // clear two item from the stack
+}
+
+static void op_test_lt(const decoded_inst_t *inst) 
+{
+    if (ctx->stack[ctx->stack_ptr-1] < ctx->stack[ctx->stack_ptr-2]){
+        ctx->sequence_ptr++;
+    }
+    ctx->stack_ptr -= 2;
+}
+
+static void op_test_gt(const decoded_inst_t *inst) 
+{
+    if (ctx->stack[ctx->stack_ptr-1] > ctx->stack[ctx->stack_ptr-2]){
+        ctx->sequence_ptr++;
+    }
+    ctx->stack_ptr -= 2;
+}
+
+static void op_read_chan_imm(const decoded_inst_t *inst) 
+{
+    cmd_push_L8(get_adc(inst->data));
+}
+
+static void op_read_chan_stk(const decoded_inst_t *inst) 
+{
+uint8_t   chan;
+
+    chan = cmd_pop_8();
+    if (chan > REAR_SENSOR) {
+        cmd_push_L8(0);            // ADCH of 0x1F turns the a/d off : 'get_adc' would never finish
+    } else {
+        cmd_push_L8(get_adc(chan));
+    }
+}
+
+static void op_delay_imm(const decoded_inst_t *inst) 
+{
+    start_wait(WAIT_DELAY, (inst->data * 100)/8);
+}
+
+static void op_delay_stk(const decoded_inst_t *inst) 
+{
+    start_wait(WAIT_DELAY, cmd_pop_16());
+}
+
+//
+// superinstructions : fused forms of the common motion groups
+//
+static void op_set_speeds(const decoded_inst_t *inst) 
+{
+uint8_t  drive;
+
+    drive = inst->handler - H_DRIVE_FORWARD;          // same bit pattern as the modifier
+    if (drive & LEFT_REVERSE) {
+        ctx->left_direction = MOTOR_BACKWARD;
+    } else {
+        ctx->left_direction = MOTOR_FORWARD;
+    }
+    if (drive & RIGHT_REVERSE) {
+        ctx->right_direction = MOTOR_BACKWARD;
+    } else {
+        ctx->right_direction = MOTOR_FORWARD;
+    }
+    ctx->left_speed = inst->data + left_motor_tweak;
+    ctx->right_speed = inst->data + right_motor_tweak;
+}
+
+static void op_timed_move(const decoded_inst_t *inst) 
+{
+    ctx->time = (inst->data * 100)/8;
+    op_move_time(inst);
+}
+
+static void op_distance_move(const decoded_inst_t *inst) 
+{
+    ctx->distance = inst->data;
+    op_move_distance(inst);
+}
+
+static void op_exit(const decoded_inst_t *inst) 
+{
+    ctx->running = NO;
+}
+
 //
-// calculate speed tweak from reading from POT_1
-//    
+// event waits : the sequence is suspended until the condition is true
+//
+static void op_wait_until(const decoded_inst_t *inst) 
+{
+    ctx->wait_unit = inst->data;
+    ctx->wait_cmp = inst->handler - H_WAIT_UNTIL_EQ;  // EQ, LT or GT
+    ctx->wait_target = cmd_pop_16();
+    ctx->wait = WAIT_ON_SENSOR;
+}
+
+static void op_wait_wheel(const decoded_inst_t *inst) 
+{
+    if (inst->handler == H_WAIT_WHEEL_LEFT) {
+        ctx->wait_unit = LEFT_MOTOR;
+    } else {
+        ctx->wait_unit = RIGHT_MOTOR;
+    }
+    ctx->wait_start = read_wheel_count(ctx->wait_unit);
+    ctx->wait_target = inst->data;
+    ctx->wait = WAIT_ON_WHEEL;
+}
+
+static void op_wait_switch(const decoded_inst_t *inst) 
+{
+    ctx->wait_unit = inst->data;
+    ctx->wait = WAIT_ON_SWITCH_PRESS;
+}
+
+static void op_call(const decoded_inst_t *inst) 
+{
+    if (ctx->return_ptr >= RETURN_STACK_SIZE) {
+        stop_sequence();                   // nested too deeply
+        return;
+    }
+    ctx->return_stack[ctx->return_ptr] = (uint8_t)ctx->sequence_ptr;
+    ctx->return_ptr++;
+    ctx->sequence_ptr = inst->data;
+}
+
+static void op_ret(const decoded_inst_t *inst) 
+{
+    if (ctx->return_ptr == 0) {
+        op_exit(inst);                     // RET from main sequence ends it
+        return;
+    }
+    ctx->return_ptr--;
+    ctx->sequence_ptr = ctx->return_stack[ctx->return_ptr];
+}
+
+static void op_invalid(const decoded_inst_t *inst) 
+{
+    stop_sequence();                   // never reached in a verified sequence
+}
+
+//
+// handler table : order MUST match the 'handler_t' list
+//
+typedef void (*inst_handler_t)(const decoded_inst_t *inst);
+
+static const inst_handler_t  inst_handlers[NOS_HANDLERS] = {
+    op_nop,
+    op_push_16_imm, op_push_16_reg,
+    op_push_L8_imm, op_push_L8_reg,
+    op_push_H8_imm, op_push_H8_reg,
+    op_pop_8,       op_pop_16,
+    op_set_speed,   op_set_distance, op_set_time,
+    op_add,
+    op_goto,
+    op_dec_and_skip,
+    op_move_time,   op_move_distance, op_start, op_stop,
+    op_test_eq,     op_test_lt,       op_test_gt,
+    op_read_chan_imm, op_read_chan_stk,
+    op_delay_imm,   op_delay_stk,
+    op_set_speeds,  op_set_speeds,    op_set_speeds, op_set_speeds,
+    op_timed_move,  op_distance_move,
+    op_call,        op_ret,
+    op_wait_until,  op_wait_until,    op_wait_until,
+    op_wait_wheel,  op_wait_wheel,
+    op_wait_switch,
+    op_exit,
+    op_invalid,
+};
+
+//
+// stack usage of each handler : entries needed on entry and net change
+//
+static const struct {
+    uint8_t   needs;
+    int8_t    change;
+} stack_effect[NOS_HANDLERS] = {
+    {0, 0},                                     // H_NOP
+    {0, 1}, {0, 1},                             // H_PUSH_16_IMM, H_PUSH_16_REG
+    {0, 1}, {0, 1},                             // H_PUSH_L8_IMM, H_PUSH_L8_REG
+    {1, 0}, {1, 0},                             // H_PUSH_H8_IMM, H_PUSH_H8_REG
+    {1, -1}, {1, -1},                           // H_POP_8, H_POP_16
+    {3, -3}, {1, -1}, {1, -1},                  // H_SET_SPEED, H_SET_DISTANCE, H_SET_TIME
+    {2, -1},                                    // H_ADD
+    {0, 0},                                     // H_GOTO
+    {0, 0},                                     // H_DEC_AND_SKIP
+    {0, 0}, {0, 0}, {0, 0}, {0, 0},             // H_MOVE_TIME, H_MOVE_DISTANCE, H_START, H_STOP
+    {2, -2}, {2, -2}, {2, -2},                  // H_TEST_EQ, H_TEST_LT, H_TEST_GT
+    {0, 1}, {1, 0},                             // H_READ_CHAN_IMM, H_READ_CHAN_STK
+    {0, 0}, {1, -1},                            // H_DELAY_IMM, H_DELAY_STK
+    {0, 0}, {0, 0}, {0, 0}, {0, 0},             // H_DRIVE_xxx
+    {0, 0}, {0, 0},                             // H_TIMED_MOVE, H_DISTANCE_MOVE
+    {0, 0}, {0, 0},                             // H_CALL, H_RET
+    {1, -1}, {1, -1}, {1, -1},                  // H_WAIT_UNTIL_xx
+    {0, 0}, {0, 0},                             // H_WAIT_WHEEL_LEFT, H_WAIT_WHEEL_RIGHT
+    {0, 0},                                     // H_WAIT_SWITCH
+    {0, 0},                                     // H_EXIT
+    {0, 0},                                     // H_INVALID
+};
+
+#ifdef PROFILE_SEQUENCES
+//----------------------------------------------------------------------------
+// Profiler
+// ========
+//
+// Per op-code count, total and longest execution time.  Times are measured
+// with the TPM1 counter (bus clock, 50nS per count) that also generates the
+// motor PWM.  It wraps every PWM period (PWM_COUNT + 1 counts, about
+// 200uS), so a single instruction that takes longer than this is
+// under-reported.
+//
+op_profile_t   sequence_profile[NOS_INSTRUCTIONS];
+uint16_t       stack_depth_profile[STACK_SIZE + 1];
+uint16_t       profile_run_ticks;
+
+//
+// op-code of each handler : order MUST match the 'handler_t' list
+//
+static const uint8_t  handler_op_code[NOS_HANDLERS] = {
+    NOS_INSTRUCTIONS,                           // H_NOP : not counted
+    PUSH_16, PUSH_16, PUSH_L8, PUSH_L8, PUSH_H8, PUSH_H8,
+    POP_8, POP_16,
+    SET_PARAMETER, SET_PARAMETER, SET_PARAMETER,
+    COMPUTE,
+    GOTO,
+    DEC_AND_SKIP,
+    EXECUTE, EXECUTE, EXECUTE, EXECUTE,
+    TEST_AND_SKIP, TEST_AND_SKIP, TEST_AND_SKIP,
+    READ_CHAN, READ_CHAN,
+    DELAY, DELAY,
+    SET_SPEEDS, SET_SPEEDS, SET_SPEEDS, SET_SPEEDS,
+    TIMED_MOVE, DISTANCE_MOVE,
+    CALL, RET,
+    WAIT_UNTIL, WAIT_UNTIL, WAIT_UNTIL,
+    WAIT_WHEEL_COUNT, WAIT_WHEEL_COUNT,
+    WAIT_SWITCH,
+    EXIT,
+    NOS_INSTRUCTIONS,                           // H_INVALID : not counted
+};
+
+//----------------------------------------------------------------------------
+// clear_sequence_profile : reset the profile counters
+// ======================
+//
+void clear_sequence_profile(void) 
+{
+uint8_t  i;
+
+    for (i=0 ; i < NOS_INSTRUCTIONS ; i++) {
+        sequence_profile[i].count = 0;
+        sequence_profile[i].total_time = 0;
+        sequence_profile[i].max_time = 0;
+    }
+    for (i=0 ; i <= STACK_SIZE ; i++) {
+        stack_depth_profile[i] = 0;
+    }
+    profile_run_ticks = 0;
+}
+
+//----------------------------------------------------------------------------
+// profile_instruction : record the execution of one instruction
+// ===================
+//
+// Parameters
+//      handler : handler that was run
+//      start   : value of TPM1CNT before the handler was called
+//
+static void profile_instruction(uint8_t handler, uint16_t start) 
+{
+uint16_t       now, elapsed;
+op_profile_t   *entry;
+
+    now = TPM1CNT;
+    elapsed = TPM1_ELAPSED(start, now);
+    if (handler_op_code[handler] >= NOS_INSTRUCTIONS) {
+        return;
+    }
+    entry = &sequence_profile[handler_op_code[handler]];
+    entry->count++;
+    entry->total_time += elapsed;
+    if (elapsed > entry->max_time) {
+        entry->max_time = elapsed;
+    }
+    stack_depth_profile[ctx->stack_ptr]++;     // depth after the instruction
+}
+#endif /* PROFILE_SEQUENCES */
+
+//----------------------------------------------------------------------------
+// predecode_instruction : convert one stored instruction into pre-decoded form
+// =====================
+//
+// Description
+//      Split a 16-bit instruction once, selecting the handler for its
+//      op-code/modifier (and sub-command) combination.  Relative GOTO
+//      targets are converted to absolute addresses.  Unknown or unused
+//      entries (e.g. erased 0xFFFF words) become H_INVALID and are
+//      rejected by 'verify_sequence' if they can be reached.
+// Parameters
+//      i       : address of the instruction in the sequence
+//      command : 16-bit instruction
+//      base    : entry in 'decoded_sequence' holding the first instruction
+//      length  : number of instructions in the sequence
+// Globals
+//      decoded_sequence
+//
+static void predecode_instruction(uint8_t i, uint16_t command, uint8_t base, uint8_t length) 
+{
+uint8_t          op_code, modifier, data;
+decoded_inst_t   *inst;
+
+    op_code  = INST_OP_CODE(command);
+    modifier = INST_MODIFIER(command);
+    data     = INST_DATA(command);
+    inst = &decoded_sequence[base + i];
+    inst->data = data;
+    inst->handler = H_INVALID;
+    switch (op_code) {
+        case PUSH_16 :
+            if (modifier == IMMEDIATE) { inst->handler = H_PUSH_16_IMM; }
+            if (modifier == REGISTER)  { inst->handler = H_PUSH_16_REG; }
+            break;
+        case PUSH_L8 :
+            if (modifier == IMMEDIATE) { inst->handler = H_PUSH_L8_IMM; }
+            if (modifier == REGISTER)  { inst->handler = H_PUSH_L8_REG; }
+            break;
+        case PUSH_H8 :
+            if (modifier == IMMEDIATE) { inst->handler = H_PUSH_H8_IMM; }
+            if (modifier == REGISTER)  { inst->handler = H_PUSH_H8_REG; }
+            break;
+        case POP_8 :
+            inst->handler = H_POP_8;
+            break;
+        case POP_16 :
+            inst->handler = H_POP_16;
+            break;
+        case SET_PARAMETER :
+            switch (data) {
+                case SPEED    : inst->handler = H_SET_SPEED;    break;
+                case DISTANCE : inst->handler = H_SET_DISTANCE; break;
+                case TIME     : inst->handler = H_SET_TIME;     break;
+            }
+            break;
+        case COMPUTE :
+            if (data == ADD) { inst->handler = H_ADD; }
+            break;
+        case GOTO :
+        case CALL :
+            if (op_code == GOTO) {
+                inst->handler = H_GOTO;
+            } else {
+                inst->handler = H_CALL;
+            }
+            switch (modifier) {
+                case ABSOLUTE       : 
+                    if (data < length) {
+                        inst->data = base + data;
+                    } else {
+                        inst->data = UNVISITED;      // out of range : rejected by verifier
+                    }
+                    break;
+                case RELATIVE_PLUS  : 
+                    if ((i + data) < length) {
+                        inst->data = base + i + data;
+                    } else {
+                        inst->data = UNVISITED;
+                    }
+                    break;
+                case RELATIVE_MINUS : 
+                    if (data <= i) {
+                        inst->data = base + i - data;
+                    } else {
+                        inst->data = UNVISITED;
+                    }
+                    break;
+                default             : inst->handler = H_INVALID; break;
+            }
+            break;
+        case RET :
+            inst->handler = H_RET;
+            break;
+        case DEC_AND_SKIP :
+            inst->handler = H_DEC_AND_SKIP;
+            break;
+        case EXECUTE :
+            switch (data) {
+                case MOVE_TIME     : inst->handler = H_MOVE_TIME;     break;
+                case MOVE_DISTANCE : inst->handler = H_MOVE_DISTANCE; break;
+                case START         : inst->handler = H_START;         break;
+                case STOP          : inst->handler = H_STOP;          break;
+            }
+            break;
+        case TEST_AND_SKIP :
+            switch (data) {
+                case EQ : inst->handler = H_TEST_EQ; break;
+                case LT : inst->handler = H_TEST_LT; break;
+                case GT : inst->handler = H_TEST_GT; break;
+            }
+            break;
+        case READ_CHAN :
+            if (modifier == IMMEDIATE) { inst->handler = H_READ_CHAN_IMM; }
+            if (modifier == STACK)     { inst->handler = H_READ_CHAN_STK; }
+            break;
+        case DELAY :
+            if (modifier == IMMEDIATE) { inst->handler = H_DELAY_IMM; }
+            if (modifier == STACK)     { inst->handler = H_DELAY_STK; }
+            break;
+        case SET_SPEEDS :
+            inst->handler = H_DRIVE_FORWARD + modifier;
+            break;
+        case TIMED_MOVE :
+            inst->handler = H_TIMED_MOVE;
+            break;
+        case DISTANCE_MOVE :
+            inst->handler = H_DISTANCE_MOVE;
+            break;
+        case WAIT_UNTIL :
+            switch (modifier) {
+                case EQ : inst->handler = H_WAIT_UNTIL_EQ; break;
+                case LT : inst->handler = H_WAIT_UNTIL_LT; break;
+                case GT : inst->handler = H_WAIT_UNTIL_GT; break;
+            }
+            break;
+        case WAIT_WHEEL_COUNT :
+            if (modifier == LEFT_MOTOR)  { inst->handler = H_WAIT_WHEEL_LEFT; }
+            if (modifier == RIGHT_MOTOR) { inst->handler = H_WAIT_WHEEL_RIGHT; }
+            break;
+        case WAIT_SWITCH :
+            inst->handler = H_WAIT_SWITCH;
+            break;
+        case EXIT :
+            inst->handler = H_EXIT;
+            break;
+        default :
+            break;
+    }
+}
+
+//----------------------------------------------------------------------------
+// sequence_length : find the number of instructions in use in a sequence
+// ===============
+//
+// Description
+//      A sequence ends at its first END_OF_SEQUENCE (0xFFFF) entry, as in
+//      a cleared RAM_sequence or erased FLASH, or after RAM_SEQUENCE_SIZE
+//      entries.  Constant sequences must end with END_OF_SEQUENCE : the
+//      zero fill of a partly initialised array is PUSH_16 #0, a valid
+//      instruction, so it cannot mark the end.
+//
+static uint8_t sequence_length(const uint16_t sequence[]) 
+{
+uint8_t  length;
+
+    for (length = 0 ; length < RAM_SEQUENCE_SIZE ; length++) {
+        if (sequence[length] == END_OF_SEQUENCE) {
+            break;
+        }
+    }
+    return length;
+}
+
+//----------------------------------------------------------------------------
+// predecode_sequence : convert a stored sequence into pre-decoded form
+// ==================
+//
+// Parameters
+//      sequence : instructions ending with END_OF_SEQUENCE (RAM or FLASH)
+//      base     : first free entry in 'decoded_sequence'
+// Results
+//      number of entries used, 0 if there is not enough room
+//
+uint8_t predecode_sequence(const uint16_t sequence[], uint8_t base) 
+{
+uint8_t  i, length;
+
+    length = sequence_length(sequence);
+    if ((length == 0) || (length > (RAM_SEQUENCE_SIZE - base))) {
+        return 0;
+    }
+    for (i=0 ; i < length ; i++) {
+        predecode_instruction(i, sequence[i], base, length);
+    }
+    return length;
+}
+
+//----------------------------------------------------------------------------
+// predecode_packed_sequence : convert a packed sequence into pre-decoded form
+// =========================
+//
+// Description
+//      Stream decoder for the compact byte encoding (see 'pack_instruction').
+//      Instructions are unpacked one at a time straight into the pre-decoded
+//      area, so a sequence held in FLASH can be run without a RAM copy.
+//      Decoding stops at PACKED_END (erased FLASH) or after 'size' bytes.
+//      The stream is read twice : once to count the instructions (needed to
+//      range check GOTO targets) and once to decode them.
+// Parameters
+//      packed : packed byte stream (RAM or FLASH)
+//      size   : maximum number of bytes in the stream
+//      base   : first free entry in 'decoded_sequence'
+// Results
+//      number of entries used, 0 if there is not enough room
+//
+uint8_t predecode_packed_sequence(const uint8_t packed[], uint16_t size, uint8_t base) 
+{
+uint8_t   i, length;
+uint16_t  pos, command;
+
+    pos = 0;
+    for (length=0 ; length < (RAM_SEQUENCE_SIZE - base) ; length++) {
+        if ((pos >= size) || (packed[pos] == PACKED_END)) {
+            break;
+        }
+        if (((pos + 1) == size) && ((packed[pos] & PACKED_SHORT) == 0)) {
+            break;                             // long form cut short
+        }
+        pos += unpack_instruction(&packed[pos], &command);
+    }
+    if ((pos < size) && (packed[pos] != PACKED_END)) {
+        return 0;                              // more code than space
+    }
+    pos = 0;
+    for (i=0 ; i < length ; i++) {
+        pos += unpack_instruction(&packed[pos], &command);
+        predecode_instruction(i, command, base, length);
+    }
+    return length;
+}
+
+//----------------------------------------------------------------------------
+// check_successor : record the stack depth on entry to a following instruction
+// ===============
+//
+// Results
+//      OK, or FAIL if the target is outside the sequence or is reached with
+//      two different stack depths
+//
+static uint8_t check_successor(uint8_t target, uint8_t depth) 
+{
+    if ((target < verify_base) || (target >= verify_end)) {
+        return FAIL;
+    }
+    if (verify_depth[target] == UNVISITED) {
+        verify_depth[target] = depth;
+        verify_changed = YES;
+        return OK;
+    }
+    if (verify_depth[target] != depth) {
+        return FAIL;
+    }
+    return OK;
+}
+
+//----------------------------------------------------------------------------
+// verify_sequence : check a pre-decoded sequence before it is run
+// ===============
+//
+// Description
+//      Walk every control-flow path from the first instruction and reject
+//      the sequence if any reachable instruction
+//          - is unknown
+//          - uses a variable outside vars[] or an invalid a/d channel
+//          - jumps or skips outside the sequence area
+//          - underflows or overflows the stack
+//          - can be reached with different stack depths
+//          - makes a CALL or RET at a different depth to any other CALL/RET
+//      CALL nesting is limited at run time by the size of 'return_stack'.
+//      Done once so the execute loop needs no run-time checks.
+// Parameters
+//      base   : entry in 'decoded_sequence' holding the first instruction
+//      length : number of instructions in the sequence
+// Results
+//      OK or FAIL.  Maximum stack depth left in 'sequence_max_depth'
+//
+uint8_t verify_sequence(uint8_t base, uint8_t length) 
+{
+uint8_t                pc, depth;
+const decoded_inst_t   *inst;
+
+    verify_base = base;
+    verify_end = base + length;
+    for (pc=verify_base ; pc < verify_end ; pc++) {
+        verify_depth[pc] = UNVISITED;
+    }
+    verify_depth[base] = 0;
+    sequence_max_depth = 0;
+    verify_call_depth = UNVISITED;
+    
+    do {
+        verify_changed = NO;
+        for (pc=verify_base ; pc < verify_end ; pc++) {
+            if (verify_depth[pc] == UNVISITED) {
+                continue;
+            }
+            inst = &decoded_sequence[pc];
+            depth = verify_depth[pc];
+        //
+        // operand checks
+        //
+            switch (inst->handler) {
+                case H_INVALID :
+                    return FAIL;
+                case H_PUSH_16_REG :
+                case H_PUSH_L8_REG :
+                case H_PUSH_H8_REG :
+                case H_POP_8 :
+                case H_POP_16 :
+                case H_DEC_AND_SKIP :
+                    if (inst->data >= NOS_VARIABLES) {
+                        return FAIL;
+                    }
+                    break;
+                case H_READ_CHAN_IMM :
+                case H_WAIT_UNTIL_EQ :
+                case H_WAIT_UNTIL_LT :
+                case H_WAIT_UNTIL_GT :
+                    if (inst->data > REAR_SENSOR) {
+                        return FAIL;
+                    }
+                    break;
+                case H_WAIT_SWITCH :
+                    if ((inst->data < SW_B) || (inst->data > SW_D)) {
+                        return FAIL;           // switch A is reserved to stop the run
+                    }
+                    break;
+                default :
+                    break;
+            }
+        //
+        // stack checks
+        //
+            if (depth < stack_effect[inst->handler].needs) {
+                return FAIL;
+            }
+            depth = depth + stack_effect[inst->handler].change;
+            if (depth > STACK_SIZE) {
+                return FAIL;
+            }
+            if (depth > sequence_max_depth) {
+                sequence_max_depth = depth;
+            }
+        //
+        // follow control flow
+        //
+            switch (inst->handler) {
+                case H_EXIT :
+                    break;
+                case H_GOTO :
+                    if (check_successor(inst->data, depth) == FAIL) {
+                        return FAIL;
+                    }
+                    break;
+                case H_RET :
+                case H_CALL :
+                //
+                // every CALL and RET must see the same stack depth so that a
+                // subroutine leaves the stack as it found it
+                //
+                    if (verify_call_depth == UNVISITED) {
+                        verify_call_depth = depth;
+                    } else if (verify_call_depth != depth) {
+                        return FAIL;
+                    }
+                    if (inst->handler == H_RET) {
+                        break;
+                    }
+                    if (check_successor(inst->data, depth) == FAIL) {
+                        return FAIL;
+                    }
+                    if (check_successor(pc + 1, depth) == FAIL) {
+                        return FAIL;
+                    }
+                    break;
+                case H_DEC_AND_SKIP :
+                case H_TEST_EQ :
+                case H_TEST_LT :
+                case H_TEST_GT :
+                    if (check_successor(pc + 2, depth) == FAIL) {
+                        return FAIL;
+                    }
+                    // fall through to next instruction
+                default :
+                    if (check_successor(pc + 1, depth) == FAIL) {
+                        return FAIL;
+                    }
+                    break;
+            }
+        }
+    } while (verify_changed == YES);
+    return OK;
+}
+
+//----------------------------------------------------------------------------
+// load_decoded_sequence : verify a pre-decoded sequence and give it a context
+// =====================
+//
+// Parameters
+//      length : number of entries used from 'code_free' (0 if it did not fit)
+// Results
+//      OK, or FAIL if the sequence did not fit or was rejected by the verifier
+//
+static uint8_t load_decoded_sequence(uint8_t length) 
+{
+    if ((length == 0) || (nos_contexts >= MAX_SEQUENCES)) {
+        return FAIL;
+    }
+    if (verify_sequence(code_free, length) == FAIL) {
+        return FAIL;
+    }
+    init_context(&contexts[nos_contexts], code_free, length);
+    nos_contexts++;
+    code_free += length;
+    return OK;
+}
+
+//----------------------------------------------------------------------------
+// set_speed_tweaks : calculate motor speed tweaks from POT_1
+// ================
+//
+static void set_speed_tweaks(void) 
+{
+uint8_t  ad_value, speed_tweak;
+
     ad_value = get_adc(POT_1);        
     speed_tweak = (ad_value >> 4) & 0x0F;
     left_motor_tweak = 0;
@@ -225,206 +1333,336 @@ uint16_t time, target_time;
     if (speed_tweak < 7) {
         right_motor_tweak = 7 - speed_tweak;
     }
+}
+
+//----------------------------------------------------------------------------
+// start_sequence : prepare a sequence of robot commands for execution
+// ==============
 //
-// command execute loop
-//    
-    FOREVER {
-        decode_command(sequence[sequence_ptr]);    
-        switch (robot_command.op_code) {
-            case PUSH_L8 :
-                switch (robot_command.modifier) {
-                    case IMMEDIATE :
-                        cmd_push_L8((uint8_t)robot_command.data);
-                        break;
-                    case REGISTER :
-                        cmd_push_L8((uint8_t)vars[robot_command.data]);
-                        break;
-                }
-                break;
+// Description
+//      Remove any loaded sequences, then pre-decode and verify the new
+//      sequence and set the motor speed tweaks.  The sequence is then run
+//      by calls to 'step_sequence'.  Further sequences can be run along
+//      side it with 'add_sequence'.
+// Parameters
+//      sequence : array of instructions
+// Results
+//      OK, or FAIL if the sequence was rejected by the verifier
 //
-            case PUSH_H8 :
-                switch (robot_command.modifier) {
-                    case IMMEDIATE :
-                        cmd_push_H8((uint8_t)robot_command.data);
-                        break;
-                    case REGISTER :
-                        cmd_push_H8((uint8_t)vars[robot_command.data]);
-                        break;
-                }
-                break;
+uint8_t start_sequence(const uint16_t  sequence[]) 
+{
+    init_for_sequence_execution();
+    if (load_decoded_sequence(predecode_sequence(sequence, code_free)) == FAIL) {
+        return FAIL;
+    }
+    set_speed_tweaks();
+    return OK;
+}
+
+//----------------------------------------------------------------------------
+// start_packed_sequence : prepare a packed sequence of robot commands for execution
+// =====================
 //
-            case PUSH_16 :                           // only available in REGISTER mode
-                switch (robot_command.modifier) {
-                    case IMMEDIATE :
-                        cmd_push_L8((uint8_t)robot_command.data);
-                        break;
-                    case REGISTER :
-                        cmd_push_16(vars[robot_command.data]);
-                        break;
-                }
-                break;
-//
-            case POP_8 : 
-                vars[robot_command.data] = cmd_pop_8();
-                break;
-//
-            case POP_16 : 
-                vars[robot_command.data] = cmd_pop_16();
-                break;
-//
-            case SET_PARAMETER :
-                switch (robot_command.data) {
-                    case SPEED :
-                        if (cmd_pop_16() == LEFT_MOTOR) {
-                            sequence_left_direction = cmd_pop_16();
-                            sequence_left_speed = cmd_pop_16() + left_motor_tweak;
-                        } else {
-                            sequence_right_direction = cmd_pop_16();
-                            sequence_right_speed = cmd_pop_16() + right_motor_tweak; 
-                        }   
-                        break;
-                    case DISTANCE :
-                        sequence_distance = cmd_pop_16();
-                        break;
-                    case TIME :
-                        sequence_time = cmd_pop_16();
-                        break;
-                }
-                break;
-//
-            case COMPUTE :
-                switch (robot_command.data) {
-                    case ADD :
-                        stack.item_16[stack_ptr-2] = stack.item_16[stack_ptr-1] + stack.item_16[stack_ptr-2];
-                        stack_ptr--;
-                        break;
-                }
-                break;
+// Parameters
+//      packed : packed byte stream (e.g. FLASH_seq_0)
+//      size   : maximum number of bytes in the stream
+// Results
+//      OK, or FAIL if the sequence was rejected by the verifier
 //
-            case GOTO : 
-                switch (robot_command.modifier) {
-                    case ABSOLUTE :
-                        sequence_ptr = ((uint8_t)robot_command.data);
-                        break;
-                    case RELATIVE_PLUS :
-                        sequence_ptr = sequence_ptr + ((uint8_t)robot_command.data);
-                        break;
-                    case RELATIVE_MINUS :
-                        sequence_ptr = sequence_ptr - ((uint8_t)robot_command.data);
-                        break;
-                }
-                break;
-//
-            case DEC_AND_SKIP :
-                vars[robot_command.data]--;
-                if (vars[robot_command.data] == 0) {
-                    sequence_ptr++;
-                }
-                break;
-//
-            case EXECUTE :
-                switch (robot_command.data) {
-                    case MOVE_TIME :
-                        CLR_TIMER16;
-                        set_motor(LEFT_MOTOR, sequence_left_direction, sequence_left_speed);
-                        set_motor(RIGHT_MOTOR, sequence_right_direction, sequence_right_speed);
-                        FOREVER {
-                            GET_TIMER16(time);
-                            if (time > sequence_time) {
-                                vehicle_stop();
-                                break;
-                            }
-                        }
-                        break;
-                    case MOVE_DISTANCE :
-                        if (sequence_left_direction == MOTOR_BACKWARD) {
-                            l_speed = -(int8_t)sequence_left_speed;
-                        } else {
-                            l_speed = (int8_t)sequence_left_speed;
-                        }
-                        if (sequence_right_direction == MOTOR_BACKWARD) {
-                            r_speed = -(int8_t)sequence_right_speed;
-                        } else {
-                            r_speed = (int8_t)sequence_right_speed;
-                        }
-                        if (sequence_left_speed > sequence_right_direction) {
-                            motor = LEFT_MOTOR; 
-                        } else {
-                            motor = RIGHT_MOTOR;
-                        }
-                        move_distance(sequence_distance, motor, l_speed, r_speed);
-                        break;
-                    case START :
-                        set_motor(LEFT_MOTOR, sequence_left_direction, sequence_left_speed);
-                        set_motor(RIGHT_MOTOR, sequence_right_direction, sequence_right_speed);
-                        break;
-                    case STOP :
-                        vehicle_stop();
-                        break;
-                }
-                break;
-//
-            case TEST_AND_SKIP :
-                switch (robot_command.data) {
-                    case EQ :
-                        if (stack.item_16[stack_ptr-1] == stack.item_16[stack_ptr-2]){
-                           sequence_ptr++;
-                        }
-                        break;
-                    case GT :
-                        if (stack.item_16[stack_ptr-1] > stack.item_16[stack_ptr-2]){
-                            sequence_ptr++;
-                        }
-                        break;
-                    case LT :
-                        if (stack.item_16[stack_ptr-1] < stack.item_16[stack_ptr-2]){
-                            sequence_ptr++;
-                        }
-                        break;
-                }
-                stack_ptr -= 2;      // clear two item from the stack
-                break;
-//
-            case READ_CHAN :
-                switch (robot_command.modifier) {
-                    case IMMEDIATE :
-                        cmd_push_L8(get_adc(robot_command.data));
-                        break;
-                    case STACK :
-                        cmd_push_L8(get_adc(cmd_pop_8()));
-                        break;
-                }
-                break;
+uint8_t start_packed_sequence(const uint8_t packed[], uint16_t size) 
+{
+    init_for_sequence_execution();
+    if (load_decoded_sequence(predecode_packed_sequence(packed, size, code_free)) == FAIL) {
+        return FAIL;
+    }
+    set_speed_tweaks();
+    return OK;
+}
+
+//----------------------------------------------------------------------------
+// add_sequence : load a further sequence to run alongside the started one
+// ============
 //
-            case DELAY :
-                switch (robot_command.modifier) {
-                    case IMMEDIATE :
-                        target_time = (robot_command.data * 100)/8;
-                        break;
-                    case STACK :
-                        target_time = cmd_pop_16();
-                        break;
-                }
-                CLR_TIMER16;
-                FOREVER {
-                    GET_TIMER16(time);
-                    if (time > target_time) {
-                        break;
-                    }
-                }
-                break;
+// Description
+//      The new sequence gets its own stack, program counter and variables
+//      V0-V11.  Variables V12-V15 are shared by all sequences, e.g. a
+//      "watcher" sequence can read a sensor into V12 for the main sequence.
+//      Must be called after 'start_sequence'.
+// Parameters
+//      sequence : array of instructions
+// Results
+//      OK, or FAIL if there is no free context or code space, or the
+//      sequence was rejected by the verifier
+//
+uint8_t add_sequence(const uint16_t  sequence[]) 
+{
+    if (nos_contexts == 0) {
+        return FAIL;
+    }
+    return load_decoded_sequence(predecode_sequence(sequence, code_free));
+}
+
+//----------------------------------------------------------------------------
+// step_context : run part of one sequence
+// ============
+//
+// Results
+//      SEQ_RUNNING, SEQ_WAITING or SEQ_DONE
+//
+static seq_status_t step_context(uint8_t max_insts) 
+{
+const decoded_inst_t  *inst;
+#ifdef PROFILE_SEQUENCES
+uint16_t              start;
+#endif
+
+    if (ctx->running == NO) {
+        return SEQ_DONE;
+    }
+    if (wait_complete() == NO) {
+        return SEQ_WAITING;
+    }
+    while (max_insts != 0) {
+        inst = &decoded_sequence[ctx->sequence_ptr];
+        ctx->sequence_ptr++;                   // onto next instruction
+#ifdef PROFILE_SEQUENCES
+        start = TPM1CNT;
+        inst_handlers[inst->handler](inst);
+        profile_instruction(inst->handler, start);
+#else
+        inst_handlers[inst->handler](inst);
+#endif
+        if (ctx->running == NO) {
+            return SEQ_DONE;
+        }
+        if (ctx->wait != WAIT_NONE) {
+            return SEQ_WAITING;
+        }
+        max_insts--;
+    }
+    return SEQ_RUNNING;
+}
+
+//----------------------------------------------------------------------------
+// step_sequence : run part of the current sequences
+// =============
+//
+// Description
+//      Give each loaded sequence, in turn, a slice of up to 'max_insts'
+//      instructions then return to the caller.  A sequence that is waiting
+//      for a motion or delay passes its slice on to the others.  The first
+//      (main) sequence controls the whole set : when it ends, any others
+//      are stopped.
+// Parameters
+//      max_insts : maximum number of instructions run by each sequence
+// Results
+//      SEQ_RUNNING, SEQ_WAITING (all sequences waiting) or SEQ_DONE
+//
+seq_status_t step_sequence(uint8_t max_insts) 
+{
+uint8_t       i, all_waiting;
+
+    if ((nos_contexts == 0) || (contexts[0].running == NO)) {
+        return SEQ_DONE;
+    }
+    all_waiting = YES;
+    for (i=0 ; i < nos_contexts ; i++) {
+        ctx = &contexts[next_context];
+        next_context++;
+        if (next_context >= nos_contexts) {
+            next_context = 0;
+        }
+        if (step_context(max_insts) == SEQ_RUNNING) {
+            all_waiting = NO;
+        }
+        if (contexts[0].running == NO) {
+            for (i=1 ; i < nos_contexts ; i++) {
+                contexts[i].running = NO;
+            }
+            left_motor_tweak = 0;
+            right_motor_tweak = 0;
+            return SEQ_DONE;
+        }
+    }
+    if (all_waiting == YES) {
+        return SEQ_WAITING;
+    }
+    return SEQ_RUNNING;
+}
+
+//----------------------------------------------------------------------------
+// stop_sequence : abandon all current sequences
+// =============
+//
+void stop_sequence(void) 
+{
+uint8_t  i;
+
+    vehicle_stop();
+    left_motor_tweak = 0;
+    right_motor_tweak = 0;
+    for (i=0 ; i < MAX_SEQUENCES ; i++) {
+        contexts[i].wait = WAIT_NONE;
+        contexts[i].running = NO;
+    }
+}
+
+//----------------------------------------------------------------------------
+// sequence_running : test whether a loaded sequence is still running
+// ================
+//
+// Parameters
+//      seq : sequence number (0 = main)
+// Results
+//      YES or NO
+//
+uint8_t sequence_running(uint8_t seq) 
+{
+    if (seq >= nos_contexts) {
+        return NO;
+    }
+    return contexts[seq].running;
+}
+
+//----------------------------------------------------------------------------
+// read_sequence_variable : read a variable as seen by a loaded sequence
+// ======================
+//
+// Parameters
+//      seq : sequence number (0 = main)
+//      var : V0 to V15 (V12 to V15 are shared by all sequences)
+// Results
+//      value of the variable, 0 if 'seq' or 'var' is out of range
+//
+uint16_t read_sequence_variable(uint8_t seq, uint8_t var) 
+{
+    if ((seq >= nos_contexts) || (var >= NOS_VARIABLES)) {
+        return 0;
+    }
+    if (var < NOS_LOCAL_VARIABLES) {
+        return contexts[seq].vars[var];
+    }
+    return shared_vars[var - NOS_LOCAL_VARIABLES];
+}
+
+//----------------------------------------------------------------------------
+// read_sequence_stack : copy the data stack of a loaded sequence
+// ===================
+//
+// Parameters
+//      seq   : sequence number (0 = main)
+//      stack : STACK_SIZE entries, bottom of the stack first
+// Results
+//      number of entries on the stack
+//
+uint8_t read_sequence_stack(uint8_t seq, uint16_t stack[]) 
+{
+uint8_t  i;
+
+    if (seq >= nos_contexts) {
+        return 0;
+    }
+    for (i=0 ; i < contexts[seq].stack_ptr ; i++) {
+        stack[i] = contexts[seq].stack[i];
+    }
+    return contexts[seq].stack_ptr;
+}
+
+//----------------------------------------------------------------------------
+// run_sequences : run a set of robot command sequences side by side
+// =============
 //
-            case EXIT :
-                left_motor_tweak = 0;
-                right_motor_tweak = 0;
-                return;
-                break;
+// Description
+//      The first sequence is the main one; the others run alongside it
+//      until it ends (see 'add_sequence').  The sequences are stepped a few
+//      instructions at a time; pressing switch A stops them at the next
+//      step.  If any sequence fails verification none are run.
+// Parameters
+//      sequences : list of instruction arrays
+//      count     : number of sequences (1 to MAX_SEQUENCES)
+// Results
+//      None
 //
-            default :
-                break;
+void run_sequences(const uint16_t * const sequences[], uint8_t count) 
+{
+uint8_t  i, status;
+
+    status = start_sequence(sequences[0]);
+    for (i=1 ; (i < count) && (status == OK) ; i++) {
+        status = add_sequence(sequences[i]);
+    }
+    run_started_sequence(status);
+}
+
+//----------------------------------------------------------------------------
+// run_sequence : run a sequence of robot commands
+// ============
+//
+// Description
+//      Execute a specified sequence of robot command.  The sequence is
+//      stepped a few instructions at a time; pressing switch A stops it
+//      at the next step.  A sequence that fails verification is not run.
+// Parameters
+//      program : array of instructions
+// Results
+//      None
+//
+void run_sequence(const uint16_t  sequence[]) 
+{
+    run_sequences(&sequence, 1);
+}
+
+//----------------------------------------------------------------------------
+// run_packed_sequence : run a packed sequence of robot commands
+// ===================
+//
+// Description
+//      As 'run_sequence' but the instructions are streamed from the compact
+//      encoding, e.g. directly from FLASH_seq_0.
+// Parameters
+//      packed : packed byte stream
+//      size   : maximum number of bytes in the stream
+//
+void run_packed_sequence(const uint8_t packed[], uint16_t size) 
+{
+    run_started_sequence(start_packed_sequence(packed, size));
+}
+
+//----------------------------------------------------------------------------
+// run_started_sequence : step a started sequence until done or switch A pressed
+// ====================
+//
+static void run_started_sequence(uint8_t start_status) 
+{
+seq_status_t  status;
+#ifdef PROFILE_SEQUENCES
+uint16_t  start_ticks;
+
+    clear_sequence_profile();
+    GET_TIMER16(start_ticks);
+#endif
+    if (start_status == FAIL) {
+        play_tune(&snd_fault);
+        return;
+    }
+    FOREVER {
+        if (switch_A == PRESSED) {
+            stop_sequence();
+            WAIT_SWITCH_RELEASED(switch_A);
+            break;
+        }
+        status = step_sequence(SEQUENCE_STEP_SIZE);
+        if (status == SEQ_DONE) {
+            break;
+        }
+        if (status == SEQ_WAITING) {
+            CPU_IDLE;              // sleep until the next interrupt
         }
-        sequence_ptr++;        // onto next instruction
     }
+#ifdef PROFILE_SEQUENCES
+    GET_TIMER16(profile_run_ticks);
+    profile_run_ticks -= start_ticks;
+#endif
 }
 
 //----------------------------------------------------------------------------
@@ -440,6 +1678,7 @@ uint16_t time, target_time;
 //      uint8_t         inst_ptr    : current pointer to next free location
 //      instruction_t   inst        : instruction
 //      uint8_t         modifier    : instruction modifier
+//                                    (direction pattern for SET_SPEEDS e.g. DRIVE_SPIN_LEFT)
 //      uint8_t         data        : instruction data
 //
 // Returned data
@@ -450,7 +1689,7 @@ void store_instruction(uint16_t sequence[], uint8_t inst_ptr, instruction_t inst
 {
 uint16_t temp16;
 
-    temp16 = ((((inst)<<8)&0x3F00) | (((modifier)<<8)&0xC000) | (((data))&0x00FF));
+    temp16 = INSTRUCTION(inst, modifier, data);
     sequence[inst_ptr] = temp16;
     
     return;    
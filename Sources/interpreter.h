@@ -23,13 +23,37 @@ typedef enum {CMD_FORWARD = 10, CMD_BACKWARD, CMD_SPIN_LEFT, CMD_SPIN_RIGHT, CMD
 
 typedef enum { PUSH_16, PUSH_L8, PUSH_H8, POP_8, POP_16, SET_PARAMETER, 
        COMPUTE, GOTO, EXECUTE, DEC_AND_SKIP, TEST_AND_SKIP, READ_CHAN, EXIT, DELAY,
+       SET_SPEEDS, TIMED_MOVE, DISTANCE_MOVE, CALL, RET,
+       WAIT_UNTIL, WAIT_WHEEL_COUNT, WAIT_SWITCH,
 } instruction_t;
 
+#define   NOS_INSTRUCTIONS   (WAIT_SWITCH + 1)
+
+//
+// 16-bit instruction word : bit 15-14 = modifier, bit 13-8 = op-code, bit 7-0 = data
+//
+#define  INSTRUCTION(OP_CODE, MODIFIER, DATA)  ((((OP_CODE)<<8)&0x3F00) | (((MODIFIER)<<14)&0xC000) | (((DATA))&0x00FF))
+#define  INST_OP_CODE(INST)     ((uint8_t)(((INST) >> 8) & 0x3F))
+#define  INST_MODIFIER(INST)    ((uint8_t)(((INST) >> 14) & 0x03))
+#define  INST_DATA(INST)        ((uint8_t)((INST) & 0xFF))
+
 enum { SPEED, DISTANCE, TIME, };
 enum { ADD, };
 enum { MOVE_TIME, MOVE_DISTANCE, START, STOP };
 enum { EQ, LT, GT };
+enum { SW_A, SW_B, SW_C, SW_D };             // WAIT_SWITCH data
 enum { NO, YES };
+
+//
+// result of a call to 'step_sequence'
+//
+typedef enum { SEQ_RUNNING, SEQ_WAITING, SEQ_DONE } seq_status_t;
+
+#define   SEQUENCE_STEP_SIZE    8     // instructions run per call to step_sequence
+#define   MAX_SEQUENCES         2     // number of sequences that can run side by side
+#define   STACK_SIZE            8     // number of 16-bit elements on each sequence stack
+
+//#define   PROFILE_SEQUENCES           // record op-code counts and times (about 150 bytes of RAM)
     
 //
 // instruction modifiers
@@ -43,13 +67,42 @@ enum { NO, YES };
 #define   RELATIVE_PLUS      1
 #define   RELATIVE_MINUS     2
 
+#define   LEFT_REVERSE       0x01      // SET_SPEEDS : direction bits
+#define   RIGHT_REVERSE      0x02
+
+#define   DRIVE_FORWARD      0
+#define   DRIVE_SPIN_LEFT    (LEFT_REVERSE)
+#define   DRIVE_SPIN_RIGHT   (RIGHT_REVERSE)
+#define   DRIVE_BACKWARD     (LEFT_REVERSE | RIGHT_REVERSE)
+
 #define   NO_DATA      0
 
+#define   END_OF_SEQUENCE      0xFFFF    // unused entry : ends a stored sequence (erased FLASH)
+
+//
+// compact FLASH encoding (see 'pack_instruction')
+//
+#define   PACKED_SHORT         0x20      // bit 5 of first byte : 1-byte form
+#define   PACKED_MAX_OP_CODE   0x1F      // op-codes must be below this value
+#define   PACKED_END           0xFF      // end of packed sequence (erased FLASH)
+
 //
 // definition of variable addresses
 //
 enum {V0, V1, V2, V3, V4, V5, V6, V7, V8, V9, V10, V11, V12, V13, V14, V15 };  // var_names;
 
+//----------------------------------------------------------------------------
+// pre-decoded form of a robot instruction
+//
+//      Built once by 'predecode_sequence' before a sequence is run.  The
+//      op-code and modifier are folded into a single handler index and the
+//      data byte is held ready for use (GOTO targets are made absolute).
+//
+typedef struct {
+    uint8_t     handler;
+    uint8_t     data;
+} decoded_inst_t;
+
 //----------------------------------------------------------------------------
 // set of sequence commands 
 //
@@ -57,6 +110,25 @@ enum {V0, V1, V2, V3, V4, V5, V6, V7, V8, V9, V10, V11, V12, V13, V14, V15 };  /
 //              DECSKIP, CALC, TESTSKIP
 //} COMMAND;
 
+extern const char * const inst_names[NOS_INSTRUCTIONS];
+
+#ifdef PROFILE_SEQUENCES
+//
+// profile of one op-code : times in TPM1 counts (50nS)
+//
+typedef struct {
+    uint16_t    count;
+    uint32_t    total_time;
+    uint16_t    max_time;
+} op_profile_t;
+
+extern op_profile_t  sequence_profile[NOS_INSTRUCTIONS];
+extern uint16_t      stack_depth_profile[STACK_SIZE + 1];   // instructions run at each stack depth
+extern uint16_t      profile_run_ticks;        // length of last run in 8mS ticks
+
+void clear_sequence_profile(void);
+#endif
+
 //----------------------------------------------------------------------------
 // prototypes
 //
@@ -66,12 +138,27 @@ void cmd_push_H8(uint8_t value);
 void cmd_push_16(uint16_t value);
 uint8_t cmd_pop_8(void);
 uint16_t cmd_pop_16(void);
-void run_sequence(uint16_t  sequence[]);
+uint8_t predecode_sequence(const uint16_t sequence[], uint8_t base);
+uint8_t predecode_packed_sequence(const uint8_t packed[], uint16_t size, uint8_t base);
+uint8_t verify_sequence(uint8_t base, uint8_t length);
+uint8_t start_sequence(const uint16_t  sequence[]);
+uint8_t start_packed_sequence(const uint8_t packed[], uint16_t size);
+uint8_t add_sequence(const uint16_t  sequence[]);
+seq_status_t step_sequence(uint8_t max_insts);
+void stop_sequence(void);
+uint8_t sequence_running(uint8_t seq);
+uint16_t read_sequence_variable(uint8_t seq, uint8_t var);
+uint8_t read_sequence_stack(uint8_t seq, uint16_t stack[]);
+void run_sequences(const uint16_t * const sequences[], uint8_t count);
+void run_sequence(const uint16_t  sequence[]);
+void run_packed_sequence(const uint8_t packed[], uint16_t size);
 void store_instruction(uint16_t sequence[], 
                           uint8_t inst_ptr, 
                           instruction_t inst, 
                           uint8_t modifier, 
                           uint8_t data);
 void decode_command(uint16_t command); 
+uint8_t pack_instruction(uint16_t command, uint8_t packed[]);
+uint8_t unpack_instruction(const uint8_t packed[], uint16_t *command);
 
 #endif /* __interpreter_H */
\ No newline at end of file
@@ -10,6 +10,7 @@
 //          1. IRQ        : left wheel sensor
 //          2. KBI (P4)   : right wheel sensor
 //          3. RTI        : 8mS timer 
+//          4. ADC        : conversion complete (see adc.c)
 //
 // Author                Date          Comment
 //----------------------------------------------------------------------------
@@ -23,12 +24,27 @@
 uint16_t    tick_count_16;           // rolls over after 524.28 seconds (8.7 minutes)
 uint8_t     tick_count_8;            // rolls over after 2.04 seconds
 uint8_t     second_count;            // rolls over after 255 seconds
-uint8_t     tick_for_second_count;
+//
+// table of periodic tasks run by the RTI interrupt
+//
+rti_task_t  rti_tasks[MAX_RTI_TASKS];
+uint8_t     nos_rti_tasks;           // slots in use are 0 to nos_rti_tasks-1
 //
 // switch data
 //
-uint8_t     switch_debounced_state, switch_states[SWITCH_SAMPLES];
-uint8_t     sample_index, debounced_state;
+uint8_t     debounced_state;                           // port C, 1 = released
+uint8_t     debounce_count_0, debounce_count_1;        // vertical counter
+uint8_t     switch_press_edges, switch_release_edges;  // set by RTI, cleared by reader
+uint16_t    switch_press_tick[NOS_SWITCHES], switch_long_ticks[NOS_SWITCHES];   // 'timer_ticks' values
+//
+// switch event queue : head only written by RTI, tail only by 'get_switch_event'
+//
+switch_event_t      switch_events[SWITCH_EVENT_QUEUE_SIZE];
+volatile uint8_t    switch_event_head, switch_event_tail;
+
+static const uint8_t  switch_bits[NOS_SWITCHES] = {
+    SWITCH_A_BIT, SWITCH_B_BIT, SWITCH_C_BIT, SWITCH_D_BIT
+};
 uint8_t     switch_A, switch_B, switch_C, switch_D, switch_ABCD;
 //
 // display data
@@ -40,12 +56,17 @@ uint8_t     display_no;
 //
 uint16_t    left_wheel_count, right_wheel_count;
 uint8_t     left_wheel_sensor_value, right_wheel_sensor_value;
-uint8_t     left_speed_index, right_speed_index;
-uint16_t    left_speed_array[64], right_speed_array[64];
 //
 // sound system data
 //
 uint8_t     note_pt, note_duration;
+#ifdef TIME_INTERRUPTS
+//
+// interrupt timing data
+//
+isr_timing_t    isr_timing[NOS_TIMED_ISRS];
+uint16_t        mask_start_time, max_masked_time;
+#endif
 
 
 
@@ -63,9 +84,11 @@ uint8_t     note_pt, note_duration;
 //----------------------------------------------------------------------------
 
 interrupt VectorNumber_Virq void Virq1(void) {
+ISR_TIME_START
 
     IRQ_ACK;                   /* Reset real-time interrupt request flag */
     irq_isr();
+    ISR_TIME_END(ISR_IRQ)
 }
 
 //----------------------------------------------------------------------------
@@ -77,9 +100,11 @@ interrupt VectorNumber_Virq void Virq1(void) {
 //----------------------------------------------------------------------------
 
 interrupt VectorNumber_Vkeyboard1  void Vkbi1(void) {
+ISR_TIME_START
 
     KBI_ACK;                   /* Reset KBI interrupt request flag */
     kbi_isr();
+    ISR_TIME_END(ISR_KBI)
 }
 
 //----------------------------------------------------------------------------
@@ -91,9 +116,52 @@ interrupt VectorNumber_Vkeyboard1  void Vkbi1(void) {
 //----------------------------------------------------------------------------
 
 interrupt VectorNumber_Vrti void Vrti1(void) {
+ISR_TIME_START
 
     SRTISC_RTIACK = 1;                   /* Reset real-time interrupt request flag */
     rti_isr();
+    ISR_TIME_END(ISR_RTI)
+}
+
+//----------------------------------------------------------------------------
+// Vadc1   first level interrupt handler for ADC conversion complete.
+// =====
+// 
+// 1. Call interrupt service routine (reading the result acknowledges it)
+//----------------------------------------------------------------------------
+
+interrupt VectorNumber_Vadc1 void Vadc1(void) {
+ISR_TIME_START
+
+    adc_isr();
+    ISR_TIME_END(ISR_ADC)
+}
+
+//----------------------------------------------------------------------------
+// Vsci1rx1   first level interrupt handler for SCI receive.
+// ========
+// 
+// 1. Disable the receive interrupt.  It is only used to wake the CPU in
+//    'sci_rx_byte', which reads the character.
+//----------------------------------------------------------------------------
+
+interrupt VectorNumber_Vsci1rx void Vsci1rx1(void) {
+
+    SCI1C2_RIE = 0;
+}
+
+//----------------------------------------------------------------------------
+// Vtpm1ovf1   first level interrupt handler for TPM1 overflow (every 200uS).
+// =========
+// 
+// 1. Call interrupt service routine (acknowledges the overflow)
+//----------------------------------------------------------------------------
+
+interrupt VectorNumber_Vtpm1ovf void Vtpm1ovf1(void) {
+ISR_TIME_START
+
+    clock_isr();
+    ISR_TIME_END(ISR_TPM1)
 }
 
 //----------------------------------------------------------------------------
@@ -141,20 +209,18 @@ void kbi_isr(void) {
 //
 // Description
 //      Background timer interrupt occurs every 8ms.
-//      User to schedule a range of timed activities.
+//      Counts the 8mS ticks then runs each task in the table that is
+//      due on this tick.
 // Notes
-//      rather goes against the idea of making interrupt routines
-//      as small as possible. Not sure if this could be done in a more
-//      efficient manner. 
-//      (need to measure the time this routine takes to execute)
+//      Tasks are given different phases so that the slower ones fall on
+//      different ticks, which keeps the worst case ISR time down.
 //        
 //----------------------------------------------------------------------------
 void rti_isr(void) {
-uint8_t   i, tmp;
+uint8_t      i;
+rti_task_t   *task_pt;
 //
-// Timer interrupt occurs every 8mS.
-//
-// Task 1 : count 8mS time units
+// count 8mS time units
 // 
 //      System has an 8-bit and 16-bit tick counters.
 //      Can be used by any routines that needs background timing (e.g. timeouts)   
@@ -162,30 +228,373 @@ uint8_t   i, tmp;
     tick_count_16++ ; 
     tick_count_8++;
 //
-// Task 2 : sample set of switches and debounce
-//          (Note : may not need to be done every 8mS)
+// run the tasks that are due
+//
+    task_pt = &rti_tasks[0];
+    for (i = 0 ; i < nos_rti_tasks ; i++, task_pt++) {
+        if (task_pt->task == NULL) {
+            continue;
+        }
+        task_pt->countdown--;
+        if (task_pt->countdown == 0) {
+            task_pt->countdown = task_pt->period;
+            task_pt->task();
+        }
+    }
+}
+
+#ifdef TIME_INTERRUPTS
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+// Interrupt timing
+// ================
+//
+// Times are measured with the TPM1 counter (bus clock, 50nS per count)
+// that also generates the motor PWM.  It wraps every PWM period
+// (PWM_COUNT + 1 counts, about 200uS), so anything longer is under-reported.
+// Interrupts taken while 'menu_idle' sleeps see TPM1 at bus clock / 128
+// and are also under-reported.
+// The ISR time runs from the first instruction of the first level
+// handler, so the hardware stacking and compiler prologue (about 1uS)
+// are not included.  The longest masked period plus the longest ISR
+// gives the worst case latency seen by any interrupt.
+//
+//----------------------------------------------------------------------------
+// elapsed_time : TPM1 counts since 'start'
+// ============
+//
+static uint16_t elapsed_time(uint16_t start) 
+{
+uint16_t   now;
+
+    now = TPM1CNT;
+    return TPM1_ELAPSED(start, now);
+}
+
+//----------------------------------------------------------------------------
+// record_isr_time : add one run of an interrupt handler to its statistics
+// ===============
+//
+// Notes
+//      Called at the end of the first level handler, so interrupts are
+//      masked.
+//----------------------------------------------------------------------------
+void record_isr_time(timed_isr_t isr, uint16_t start) 
+{
+uint16_t       elapsed;
+uint8_t        bin;
+isr_timing_t   *entry;
+
+    elapsed = elapsed_time(start);
+    entry = &isr_timing[isr];
+    entry->count++;
+    entry->total_time += elapsed;
+    if ((entry->count == 1) || (elapsed < entry->min_time)) {
+        entry->min_time = elapsed;
+    }
+    if (elapsed > entry->max_time) {
+        entry->max_time = elapsed;
+    }
+    bin = (uint8_t)(elapsed >> ISR_TIME_BIN_SHIFT);
+    if (bin >= ISR_TIME_BINS) {
+        bin = ISR_TIME_BINS - 1;
+    }
+    entry->histogram[bin]++;
+}
+
+//----------------------------------------------------------------------------
+// end_masked_period : record time since DISABLE_INTERRUPTS
+// =================
+//
+// Notes
+//      Called by ENABLE_INTERRUPTS just before interrupts are unmasked.
+//----------------------------------------------------------------------------
+void end_masked_period(void) 
+{
+uint16_t   elapsed;
+
+    elapsed = elapsed_time(mask_start_time);
+    if (elapsed > max_masked_time) {
+        max_masked_time = elapsed;
+    }
+}
+
+//----------------------------------------------------------------------------
+// clear_isr_timing : reset the interrupt timing statistics
+// ================
+//
+void clear_isr_timing(void) 
+{
+    DISABLE_INTERRUPTS;
+    memset(isr_timing, 0, sizeof(isr_timing));
+    max_masked_time = 0;
+    ENABLE_INTERRUPTS;
+}
+#endif /* TIME_INTERRUPTS */
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+// Periodic task table
+// ===================
+//
+//----------------------------------------------------------------------------
+// insert_rti_task : place a task in the first free slot of the table
+// ===============
 //
-    switch_states[sample_index] = PTCD; 
-    ++sample_index; 
-    switch_debounced_state = 0xff; 
-    for(i=0; i < SWITCH_SAMPLES; i++) { 
-        switch_debounced_state = switch_debounced_state & switch_states[i]; 
+// Notes
+//      Caller must ensure the RTI cannot run while the table is changed.
+//      'phase' is the number of ticks to wait before the first run and
+//      is used to stagger tasks that have the same period.
+//----------------------------------------------------------------------------
+static uint8_t insert_rti_task(rti_task_fn_t task, uint8_t period, uint8_t phase) 
+{
+uint8_t   i;
+
+    if ((task == NULL) || (period == 0) || (phase >= period)) {
+        return FAIL;
     }
-    debounced_state = switch_debounced_state; 
-    if(sample_index >= SWITCH_SAMPLES) {
-        sample_index = 0; 
+    for (i = 0 ; i < MAX_RTI_TASKS ; i++) {
+        if (rti_tasks[i].task == NULL) {
+            rti_tasks[i].period = period;
+            rti_tasks[i].countdown = phase + 1;
+            rti_tasks[i].task = task;
+            if (i >= nos_rti_tasks) {
+                nos_rti_tasks = i + 1;
+            }
+            return OK;
+        }
+    }
+    return FAIL;
+}
+
+//----------------------------------------------------------------------------
+// add_rti_task : add a periodic task to be run by the RTI interrupt
+// ============
+//
+// Description
+//      Task is run every 'period' ticks (8mS units), first run 'phase'
+//      ticks from now.  Used by modes that need their own background
+//      activity.  Returns FAIL if the table is full or the values are bad.
+// Notes
+//      Safe to call from an RTI task : the interrupt mask is restored, not
+//      cleared.
+//----------------------------------------------------------------------------
+uint8_t add_rti_task(rti_task_fn_t task, uint8_t period, uint8_t phase) 
+{
+uint8_t   status, ccr;
+
+    SAVE_AND_DISABLE_INTERRUPTS(ccr);
+    status = insert_rti_task(task, period, phase);
+    RESTORE_INTERRUPTS(ccr);
+    return status;
+}
+
+//----------------------------------------------------------------------------
+// remove_rti_task : stop a periodic task
+// ===============
+//
+// Notes
+//      Slot is marked free rather than the table being packed, so a task
+//      may remove itself while it is being run from the RTI.  The interrupt
+//      mask is restored rather than cleared, so interrupts stay masked when
+//      this is called from inside the ISR.
+//----------------------------------------------------------------------------
+void remove_rti_task(rti_task_fn_t task) 
+{
+uint8_t   i, ccr;
+
+    SAVE_AND_DISABLE_INTERRUPTS(ccr);
+    for (i = 0 ; i < nos_rti_tasks ; i++) {
+        if (rti_tasks[i].task == task) {
+            rti_tasks[i].task = NULL;
+        }
+    }
+    while ((nos_rti_tasks > 0) && (rti_tasks[nos_rti_tasks - 1].task == NULL)) {
+        nos_rti_tasks--;
+    }
+    RESTORE_INTERRUPTS(ccr);
+}
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+// Switch edges
+// ============
+//
+//----------------------------------------------------------------------------
+// get_switch_presses : read and clear switch press edge flags
+// ==================
+//
+// Description
+//      Returns the bits of 'mask' (e.g. SWITCH_A_BIT | SWITCH_D_BIT) whose
+//      switch has been pressed since the last call, and clears them.
+//----------------------------------------------------------------------------
+uint8_t get_switch_presses(uint8_t mask) 
+{
+uint8_t   edges;
+
+    DISABLE_INTERRUPTS;
+    edges = switch_press_edges & mask;
+    switch_press_edges &= ~edges;
+    ENABLE_INTERRUPTS;
+    return edges;
+}
+
+//----------------------------------------------------------------------------
+// get_switch_releases : read and clear switch release edge flags
+// ===================
+//
+uint8_t get_switch_releases(uint8_t mask) 
+{
+uint8_t   edges;
+
+    DISABLE_INTERRUPTS;
+    edges = switch_release_edges & mask;
+    switch_release_edges &= ~edges;
+    ENABLE_INTERRUPTS;
+    return edges;
+}
+
+//----------------------------------------------------------------------------
+// push_switch_event : add an event to the switch event queue
+// =================
+//
+// Notes
+//      Only called from the RTI.  The head index is moved after the event
+//      is written, so the reader never sees a part written event.  If the
+//      queue is full the new event is lost.
+//----------------------------------------------------------------------------
+static void push_switch_event(uint8_t type, uint8_t switch_bit, uint16_t duration) 
+{
+uint8_t   next;
+
+    next = (switch_event_head + 1) & (SWITCH_EVENT_QUEUE_SIZE - 1);
+    if (next == switch_event_tail) {
+        return;
+    }
+    switch_events[switch_event_head].type = type;
+    switch_events[switch_event_head].switch_bit = switch_bit;
+    switch_events[switch_event_head].duration = duration;
+    switch_event_head = next;
+}
+
+//----------------------------------------------------------------------------
+// get_switch_event : take the next switch event from the queue
+// ================
+//
+// Description
+//      Returns YES and fills in 'event' if an event was waiting, otherwise
+//      NO.  Never blocks, so a mode can poll it from its main loop and
+//      keep supervising the motors.
+// Notes
+//      No need to disable interrupts : 8-bit index reads are atomic and
+//      the RTI never writes the tail index.
+//----------------------------------------------------------------------------
+uint8_t get_switch_event(switch_event_t *event) 
+{
+uint8_t   tail;
+
+    tail = switch_event_tail;
+    if (tail == switch_event_head) {
+        return NO;
+    }
+    *event = switch_events[tail];
+    switch_event_tail = (tail + 1) & (SWITCH_EVENT_QUEUE_SIZE - 1);
+    return YES;
+}
+
+//----------------------------------------------------------------------------
+// flush_switch_events : discard any queued switch events
+// ===================
+//
+// Notes
+//      Used on entry to code that reads events, so it does not act on
+//      switch activity that was meant for a previous mode.
+//----------------------------------------------------------------------------
+void flush_switch_events(void) 
+{
+    switch_event_tail = switch_event_head;
+}
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+// System periodic tasks
+// =====================
+//
+//----------------------------------------------------------------------------
+// debounce_task : sample set of switches and debounce
+// =============
+//
+// Description
+//      Bit-parallel vertical counter : each bit of port C has a 2-bit
+//      counter held in bit n of 'debounce_count_0' and 'debounce_count_1'.
+//      A counter is cleared whenever its input agrees with the debounced
+//      state, so a bit only changes after SWITCH_SAMPLES (4) samples in a
+//      row disagree.  Both press and release are filtered.
+//
+//      Changed bits are ORed into 'switch_press_edges' (now 0) and
+//      'switch_release_edges' (now 1) for 'get_switch_presses' and
+//      'get_switch_releases'.  Press, release and long-press events for
+//      switches A-D are also put in the switch event queue.
+// Notes
+//      Run every 24mS, so a switch must be stable for 72-96mS.
+//      Port C bits that are not switches are forced to 1 (released).
+//      Hold times use 'timer_ticks', as modes clear 'tick_count_16'
+//      while a switch may be held.
+//----------------------------------------------------------------------------
+static void debounce_task(void) 
+{
+uint8_t    delta, changes, i, bit;
+uint16_t   held;
+
+    delta = (PTCD | ~ALL_RELEASED) ^ debounced_state;
+    debounce_count_1 = (debounce_count_1 ^ debounce_count_0) & delta;
+    debounce_count_0 = ~debounce_count_0 & delta;
+    changes = delta & ~(debounce_count_0 | debounce_count_1);
+    if (changes != 0) {
+        debounced_state ^= changes;
+        switch_press_edges |= changes & ~debounced_state;
+        switch_release_edges |= changes & debounced_state;
+        //
+        // code to extract switch bits
+        //
+        switch_A = (debounced_state & SWITCH_A_BIT) ? RELEASED : PRESSED;
+        switch_B = (debounced_state & SWITCH_B_BIT) ? RELEASED : PRESSED;
+        switch_C = (debounced_state & SWITCH_C_BIT) ? RELEASED : PRESSED;
+        switch_D = (debounced_state & SWITCH_D_BIT) ? RELEASED : PRESSED;
+        switch_ABCD = debounced_state & ALL_RELEASED;
+    } else if (switch_ABCD == ALL_RELEASED) {
+        return;                         // nothing changed and nothing held
     }
     //
-    // code to extract switch bits
+    // queue press/release events and long-press events for held switches
     //
-    switch_A = ((debounced_state & 0b00000100) >> 2 )  & 0b00000001;
-    switch_B = ((debounced_state & 0b00001000) >> 3 )  & 0b00000001;
-    switch_C = ((debounced_state & 0b00100000) >> 5 )  & 0b00000001;
-    switch_D = ((debounced_state & 0b00010000) >> 4 )  & 0b00000001;
-    switch_ABCD = debounced_state & 0b00111100;
-//
-// Task 3 : implement flashing of LED displays
+    for (i = 0 ; i < NOS_SWITCHES ; i++) {
+        bit = switch_bits[i];
+        held = timer_ticks - switch_press_tick[i];
+        if ((changes & bit) != 0) {
+            if ((debounced_state & bit) != 0) {
+                push_switch_event(SW_EVENT_RELEASE, bit, held);
+            } else {
+                switch_press_tick[i] = timer_ticks;
+                switch_long_ticks[i] = LONG_PRESS_TICKS;
+                push_switch_event(SW_EVENT_PRESS, bit, 0);
+            }
+        } else if (((debounced_state & bit) == 0) && (held >= switch_long_ticks[i])) {
+            push_switch_event(SW_EVENT_LONG_PRESS, bit, held);
+            switch_long_ticks[i] += LONG_PRESS_TICKS;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+// LED_flash_task : implement flashing of LED displays
+// ==============
 //
+// Notes
+//      'flash_count' is in 8mS units so run every tick.
+//----------------------------------------------------------------------------
+static void LED_flash_task(void) 
+{
     temp_flash_count--;                    // decrements every 8mS
     if (temp_flash_count == 0) {
         temp_flash_count = flash_count;    // reload flash counter
@@ -195,9 +604,17 @@ uint8_t   i, tmp;
             PTGD = LED_image;
         }
     }
+}
+
+//----------------------------------------------------------------------------
+// display_shift_task : shift to next characters for dual 7-segment displays
+// ==================
 //
-// Task 4 : shift to next characters for dual 7-segment displays
-//
+// Notes
+//      Run every 64mS, the unit of 'robot_display.shift_rate'.
+//----------------------------------------------------------------------------
+static void display_shift_task(void) 
+{
     if (robot_display.shift_rate != 0) {
         robot_display.shift_count--;
         if (robot_display.shift_count == 0) {
@@ -208,9 +625,15 @@ uint8_t   i, tmp;
             } 
         }
     }
+}
+
+//----------------------------------------------------------------------------
+// display_mux_task : multiplex dual 7-segment displays : 8mS switching
+// ================
 //
-// Task 5 : Multiplex dual 7-segment displays : 8mS switching
-//
+//----------------------------------------------------------------------------
+static void display_mux_task(void) 
+{
     if (display_no == SEVEN_SEG_A){
         SEG_A_CTRL = 1; SEG_B_CTRL = 0;
         PTAD = robot_display.data_A[robot_display.char_ptr];
@@ -220,9 +643,17 @@ uint8_t   i, tmp;
         PTAD = robot_display.data_B[robot_display.char_ptr];
         display_no = SEVEN_SEG_A;
     }
+}
+
+//----------------------------------------------------------------------------
+// sound_task : manage playing of current tune
+// ==========
 //
-// Task 6 : manage playing of current tune
-//
+// Notes
+//      note durations are in 8mS units so run every tick.
+//----------------------------------------------------------------------------
+static void sound_task(void) 
+{
     if (sound_file.mode == SOUND_ENABLE) { 
         if (note_duration == 0) {       // end of a note or about to start
             if (note_pt == 0) {         // start first note
@@ -250,10 +681,21 @@ uint8_t   i, tmp;
             note_duration--;
         }
     }
+}
+
+//----------------------------------------------------------------------------
+// wheel_encoder_task : read and process wheel position encoders
+// ==================
 //
-// Task 7 : Read and process wheel position encoders
-//    
-    tmp = interrupt_get_adc(WHEEL_SENSOR_L);
+// Notes
+//      Run every tick : a slower rate would miss encoder edges.
+//      Uses the values from the last background a/d scan.
+//----------------------------------------------------------------------------
+static void wheel_encoder_task(void) 
+{
+uint8_t   tmp;
+
+    tmp = get_adc(WHEEL_SENSOR_L);
    //
    // threshold value
    //
@@ -272,7 +714,7 @@ uint8_t   i, tmp;
    //
    // repeat for right sensor
    // 
-    tmp = interrupt_get_adc(WHEEL_SENSOR_R);
+    tmp = get_adc(WHEEL_SENSOR_R);
     if (tmp < FLASH_data.RIGHT_WHEEL_THRESHOLD) {
         tmp = BLACK; 
     } else {
@@ -282,23 +724,48 @@ uint8_t   i, tmp;
         right_wheel_count++;
         right_wheel_sensor_value = tmp;
     }   
+}
+
+//----------------------------------------------------------------------------
+// one_second_task : run 1 second tasks
+// ===============
 //
-// Task 8 : check for 1 second period and run 1 second tasks
-// 
-    if ((tick_for_second_count--) == 0) {
-        tick_for_second_count = TICKS_IN_ONE_SECOND;
-        //
-        //  Task 8.1 : keep second count (rolls over after 255 seconds)
-        //
-        second_count++;
-        //
-        //  Task 8.2 : read wheel counter for speed and store in circular buffer
-        //             buffer stores the last 64 values (last 64 seconds)
-        //
-//        left_speed_array[left_speed_index++] =  left_wheel_count;
-//        left_speed_index &= (sizeof(left_speed_array)/sizeof(uint16_t));         // handle circular buffer pointer
-//        right_speed_array[right_speed_index++] =  right_wheel_count;
-//        right_speed_index &= (sizeof(right_speed_array)/sizeof(uint16_t));       // handle circular buffer pointer
-    }
+//----------------------------------------------------------------------------
+static void one_second_task(void) 
+{
+    //
+    //  keep second count (rolls over after 255 seconds)
+    //
+    second_count++;
 }
 
+//----------------------------------------------------------------------------
+// init_rti_tasks : load the table with the system tasks
+// ==============
+//
+// Notes
+//      Called during initialisation before interrupts are enabled.
+//      The slow tasks are given different phases so they do not run on
+//      the same tick : debounce on ticks 0,3,6..., display shift on
+//      ticks 1,9,17..., the second task on tick 2 of each second and
+//      the sensor recorder on ticks 3,7,11...
+//----------------------------------------------------------------------------
+void init_rti_tasks(void) 
+{
+uint8_t   i;
+
+    for (i = 0 ; i < MAX_RTI_TASKS ; i++) {
+        rti_tasks[i].task = NULL;
+    }
+    nos_rti_tasks = 0;
+    insert_rti_task(start_adc_scan, RTI_EVERY_TICK, 0);
+    insert_rti_task(timer_task, RTI_EVERY_TICK, 0);
+    insert_rti_task(wheel_encoder_task, RTI_EVERY_TICK, 0);
+    insert_rti_task(display_mux_task, RTI_EVERY_TICK, 0);
+    insert_rti_task(LED_flash_task, RTI_EVERY_TICK, 0);
+    insert_rti_task(sound_task, RTI_EVERY_TICK, 0);
+    insert_rti_task(debounce_task, RTI_DEBOUNCE_PERIOD, 0);
+    insert_rti_task(display_shift_task, RTI_DISPLAY_SHIFT_PERIOD, 1);
+    insert_rti_task(one_second_task, TICKS_IN_ONE_SECOND, 2);
+    insert_rti_task(recorder_task, RECORD_PERIOD, 3);
+}
@@ -13,8 +13,81 @@
 #ifndef __interrupt_H
 #define __interrupt_H 
 
+//
+// periodic tasks run by the 8mS RTI interrupt
+//
+#define     MAX_RTI_TASKS             12
+
+#define     RTI_EVERY_TICK             1     // periods in 8mS ticks
+#define     RTI_DEBOUNCE_PERIOD        3     // 24mS
+#define     RTI_DISPLAY_SHIFT_PERIOD   8     // 64mS : unit of 'shift_rate'
+
+typedef void (*rti_task_fn_t)(void);
+
+typedef struct {
+    rti_task_fn_t   task;            // NULL if slot is free
+    uint8_t         period;          // run every 'period' ticks
+    uint8_t         countdown;       // ticks until next run
+} rti_task_t;
+
+//
+// switch events queued by the RTI debounce task
+//
+#define     SWITCH_EVENT_QUEUE_SIZE    8     // must be a power of 2
+#define     LONG_PRESS_TICKS          TICKS_IN_ONE_SECOND
+
+typedef enum {
+    SW_EVENT_PRESS,            // switch pressed
+    SW_EVENT_RELEASE,          // switch released, 'duration' = time held
+    SW_EVENT_LONG_PRESS        // switch still held after each LONG_PRESS_TICKS
+} switch_event_type_t;
+
+typedef struct {
+    uint8_t     type;            // switch_event_type_t
+    uint8_t     switch_bit;      // SWITCH_A_BIT ... SWITCH_D_BIT
+    uint16_t    duration;        // 8mS ticks since press
+} switch_event_t;
+
+#ifdef TIME_INTERRUPTS
+//
+// execution time of each first level interrupt handler (TIME_INTERRUPTS
+// is set in user_defines.h).  Times are TPM1 counts (50nS).
+//
+#define     ISR_TIME_BINS       8
+#define     ISR_TIME_BIN_SHIFT  9        // 512 counts (25.6uS) per histogram bin
+
+typedef enum {ISR_IRQ, ISR_KBI, ISR_RTI, ISR_ADC, ISR_TPM1, NOS_TIMED_ISRS} timed_isr_t;
+
+typedef struct {
+    uint16_t    count;
+    uint16_t    min_time, max_time;
+    uint32_t    total_time;
+    uint16_t    histogram[ISR_TIME_BINS];
+} isr_timing_t;
+
+extern  isr_timing_t    isr_timing[NOS_TIMED_ISRS];
+extern  uint16_t        mask_start_time, max_masked_time;
+
+#define  ISR_TIME_START         uint16_t  isr_start_time = TPM1CNT;
+#define  ISR_TIME_END(isr)      record_isr_time((isr), isr_start_time);
+
+void record_isr_time(timed_isr_t isr, uint16_t start);
+void end_masked_period(void);
+void clear_isr_timing(void);
+#else
+#define  ISR_TIME_START
+#define  ISR_TIME_END(isr)
+#endif /* TIME_INTERRUPTS */
+
 void irq_isr(void);
 void rti_isr(void);
 void kbi_isr(void);
+void init_rti_tasks(void);
+uint8_t get_switch_presses(uint8_t mask);
+uint8_t get_switch_releases(uint8_t mask);
+uint8_t get_switch_event(switch_event_t *event);
+void flush_switch_events(void);
+uint8_t add_rti_task(rti_task_fn_t task, uint8_t period, uint8_t phase);
+void remove_rti_task(rti_task_fn_t task);
 
 #endif /* __interrupt_H */
\ No newline at end of file
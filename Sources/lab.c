@@ -57,6 +57,7 @@ uint8_t   activity;
             set_LED(LED_D, FLASH_ON);
             WAIT_SWITCH_RELEASED(switch_A); 
         } else {
+            MENU_IDLE;      // nothing to do until the next tick
             continue;
         }
 //
@@ -115,8 +116,8 @@ uint8_t run_lab_mode_0(void)
 {
 mode_state_t  state;
 uint8_t       count_100mS, count_mode; 
-uint16_t      t_count, count_seconds; 
-uint32_t      count_mS;
+uint16_t      count_seconds; 
+uint32_t      start_time, count_mS;
 
     state = MODE_INIT;
     set_LED(LED_A, FLASH_ON);
@@ -166,10 +167,10 @@ uint32_t      count_mS;
 //            }
 //        }
 //
-// check for count START signal : clear timer, show cycling display and sound beeps
+// check for count START signal : note start time, show cycling display and sound beeps
 // 
         if ((count_mode == COUNTING_OFF) && (get_adc(FRONT_SENSOR_L) < SENSE_LOW)) {       // start count
-            CLR_TIMER16;
+            start_time = get_time_us();
             play_tune(&snd_beeps_1);
             display_string("_-^-_", 0);
             count_mode = COUNTING_ON;       
@@ -178,19 +179,22 @@ uint32_t      count_mS;
 // check for count STOP signal; read count and convert to x.y seconds value
 //     
         if ((count_mode == COUNTING_ON) && (get_adc(FRONT_SENSOR_R) < SENSE_LOW)) {       // start count
-            GET_TIMER16(t_count);
+            count_mS = (get_time_us() - start_time) / 1000;
             count_mode = COUNTING_OFF;       
             stop_tune();
             //
-            // convert count of 8mS units units of 1 second and units of 0.1 second
+            // convert count of mS to units of 1 second and units of 0.1 second
             //
-            count_mS = t_count * 8;   
             count_seconds = count_mS / 1000;
             count_mS = count_mS - (count_seconds * 1000);
             count_100mS = count_mS / 100;
             count_mS = count_mS - (count_100mS * 100);
             if (count_mS >= 50 ) {                     // round to nearest 0.1 second
                 count_100mS++;
+                if (count_100mS == 10) {
+                    count_100mS = 0;
+                    count_seconds++;
+                }
             }
             //
             // print to display
@@ -0,0 +1,279 @@
+//----------------------------------------------------------------------------
+//                  Robokid
+//----------------------------------------------------------------------------
+// optimise.c : peephole optimiser for stored robot sequences
+// ==========
+//
+// Description
+//      Rewrites a sequence of 16-bit robot instructions into a shorter
+//      sequence with the same behaviour.
+//          1. PUSH_L8 / PUSH_H8 pairs whose high byte is zero become a
+//             single PUSH_16
+//          2. two constant pushes followed by COMPUTE ADD become one
+//             constant push
+//          3. GOTO and CALL targets that are GOTOs are threaded to the final target
+//          4. GOTOs to the following instruction are removed
+//      No hardware access, so the same code can be built into host tools.
+//
+// Author                Date          Comment
+//----------------------------------------------------------------------------
+
+#include "global.h"
+
+#define    BAD_TARGET    0xFF
+
+//
+// working data
+//
+uint8_t    new_addr[RAM_SEQUENCE_SIZE];                  // old -> new instruction address
+uint8_t    boundary_map[(RAM_SEQUENCE_SIZE + 7) / 8];    // instructions reached other than by fall-through
+
+#define    SET_BOUNDARY(n)     boundary_map[(n) >> 3] |= (uint8_t)(1 << ((n) & 0x07))
+#define    IS_BOUNDARY(n)      ((boundary_map[(n) >> 3] & (uint8_t)(1 << ((n) & 0x07))) != 0)
+
+//----------------------------------------------------------------------------
+// goto_target : absolute address of the target of a GOTO/CALL instruction
+// ===========
+//
+// Results
+//      target address, or BAD_TARGET if it lies outside the sequence
+//
+static uint8_t goto_target(uint16_t inst, uint8_t pc, uint8_t length) 
+{
+uint16_t  target;
+
+    switch (INST_MODIFIER(inst)) {
+        case ABSOLUTE :
+            target = INST_DATA(inst);
+            break;
+        case RELATIVE_PLUS :
+            target = pc + INST_DATA(inst);
+            break;
+        case RELATIVE_MINUS :
+            if (INST_DATA(inst) > pc) {
+                return BAD_TARGET;
+            }
+            target = pc - INST_DATA(inst);
+            break;
+        default :
+            return BAD_TARGET;
+    }
+    if (target >= length) {
+        return BAD_TARGET;
+    }
+    return (uint8_t)target;
+}
+
+//----------------------------------------------------------------------------
+// is_jump : check for an instruction with a GOTO style target address
+// =======
+//
+static uint8_t is_jump(uint16_t inst) 
+{
+    if ((INST_OP_CODE(inst) == GOTO) || (INST_OP_CODE(inst) == CALL)) {
+        return YES;
+    }
+    return NO;
+}
+
+//----------------------------------------------------------------------------
+// is_skip : check for an instruction that can skip the following instruction
+// =======
+//
+static uint8_t is_skip(uint16_t inst) 
+{
+    if ((INST_OP_CODE(inst) == DEC_AND_SKIP) || (INST_OP_CODE(inst) == TEST_AND_SKIP)) {
+        return YES;
+    }
+    return NO;
+}
+
+//----------------------------------------------------------------------------
+// parse_constant : recognise an instruction group that pushes a constant
+// ==============
+//
+// Description
+//      Accepts PUSH_16/PUSH_L8 IMMEDIATE, optionally followed by a
+//      PUSH_H8 IMMEDIATE that is not itself a jump/skip target.
+// Results
+//      number of instructions in the group (0 if not a constant)
+//
+static uint8_t parse_constant(const uint16_t sequence[], uint8_t pc, uint8_t length, uint16_t *value) 
+{
+uint16_t  inst;
+
+    inst = sequence[pc];
+    if (INST_MODIFIER(inst) != IMMEDIATE) {
+        return 0;
+    }
+    if ((INST_OP_CODE(inst) != PUSH_16) && (INST_OP_CODE(inst) != PUSH_L8)) {
+        return 0;
+    }
+    *value = INST_DATA(inst);
+    pc++;
+    if ((pc < length) && !IS_BOUNDARY(pc)) {
+        inst = sequence[pc];
+        if ((INST_OP_CODE(inst) == PUSH_H8) && (INST_MODIFIER(inst) == IMMEDIATE)) {
+            *value |= ((uint16_t)INST_DATA(inst) << 8);
+            return 2;
+        }
+    }
+    return 1;
+}
+
+//----------------------------------------------------------------------------
+// emit_constant : store the shortest instruction group to push a constant
+// =============
+//
+// Results
+//      number of instructions written (1 or 2)
+//
+static uint8_t emit_constant(uint16_t sequence[], uint8_t pc, uint16_t value) 
+{
+    sequence[pc] = INSTRUCTION(PUSH_16, IMMEDIATE, (uint8_t)value);
+    if (value <= 0xFF) {
+        return 1;
+    }
+    sequence[pc + 1] = INSTRUCTION(PUSH_H8, IMMEDIATE, (uint8_t)(value >> 8));
+    return 2;
+}
+
+//----------------------------------------------------------------------------
+// optimise_sequence : apply peephole optimisations to a robot sequence
+// =================
+//
+// Description
+//      Repeats the set of optimisations until no more changes are made.
+//      A group of instructions is only merged if none of its later
+//      instructions is a jump or skip target, and a GOTO is only removed
+//      if it is not the instruction skipped by a DEC_AND_SKIP/TEST_AND_SKIP.
+//      All GOTOs and CALLs are re-written with ABSOLUTE targets.
+//      Unused locations at the end are filled with END_OF_SEQUENCE (erased FLASH).
+// Parameters
+//      sequence : sequence of instructions (modified in place)
+//      length   : number of locations in the sequence
+// Results
+//      number of locations in use after optimisation.  A sequence holding
+//      a GOTO/CALL outside the sequence is not changed.
+//
+uint8_t optimise_sequence(uint16_t sequence[], uint8_t length) 
+{
+uint8_t   pc, out, n1, n2, target, hops, changed;
+uint16_t  inst, last_inst, v1, v2;
+
+    if (length > RAM_SEQUENCE_SIZE) {
+        return length;
+    }
+//
+// convert all GOTOs and CALLs to ABSOLUTE form
+//
+    for (pc = 0 ; pc < length ; pc++) {
+        if (is_jump(sequence[pc]) == YES) {
+            target = goto_target(sequence[pc], pc, length);
+            if (target == BAD_TARGET) {
+                return length;
+            }
+            sequence[pc] = INSTRUCTION(INST_OP_CODE(sequence[pc]), ABSOLUTE, target);
+        }
+    }
+    
+    do {
+        changed = NO;
+    //
+    // thread chains of GOTOs
+    //
+        for (pc = 0 ; pc < length ; pc++) {
+            if (is_jump(sequence[pc]) == NO) {
+                continue;
+            }
+            target = INST_DATA(sequence[pc]);
+            for (hops = 0 ; hops < length ; hops++) {
+                if (INST_OP_CODE(sequence[target]) != GOTO) {
+                    break;
+                }
+                target = INST_DATA(sequence[target]);
+            }
+            if (target != INST_DATA(sequence[pc])) {
+                sequence[pc] = INSTRUCTION(INST_OP_CODE(sequence[pc]), ABSOLUTE, target);
+                changed = YES;
+            }
+        }
+    //
+    // find instructions that can be reached other than by fall-through
+    //
+        for (pc = 0 ; pc < sizeof(boundary_map) ; pc++) {
+            boundary_map[pc] = 0;
+        }
+        for (pc = 0 ; pc < length ; pc++) {
+            inst = sequence[pc];
+            if (is_jump(inst) == YES) {
+                SET_BOUNDARY(INST_DATA(inst));
+            }
+            if ((is_skip(inst) == YES) && ((pc + 2) < length)) {
+                SET_BOUNDARY(pc + 1);
+                SET_BOUNDARY(pc + 2);
+            }
+        }
+    //
+    // fold and compact (in place : 'out' never passes 'pc')
+    //
+        pc = 0;
+        out = 0;
+        last_inst = 0xFFFF;
+        while (pc < length) {
+            new_addr[pc] = out;
+            inst = sequence[pc];
+            n1 = parse_constant(sequence, pc, length, &v1);
+            if (n1 != 0) {
+                n2 = 0;
+                if (((pc + n1) < length) && !IS_BOUNDARY(pc + n1)) {
+                    n2 = parse_constant(sequence, pc + n1, length, &v2);
+                }
+                if ((n2 != 0) && ((pc + n1 + n2) < length) && !IS_BOUNDARY(pc + n1 + n2) 
+                        && (sequence[pc + n1 + n2] == INSTRUCTION(COMPUTE, NO_MOD, ADD))) {
+                    last_inst = sequence[pc + n1 + n2];
+                    for (hops = 0 ; hops <= (n1 + n2) ; hops++) {
+                        new_addr[pc + hops] = out;
+                    }
+                    out += emit_constant(sequence, out, v1 + v2);
+                    pc += n1 + n2 + 1;
+                    changed = YES;
+                    continue;
+                }
+                if ((n1 == 2) && (v1 <= 0xFF)) {
+                    last_inst = sequence[pc + 1];
+                    new_addr[pc + 1] = out;
+                    out += emit_constant(sequence, out, v1);
+                    pc += 2;
+                    changed = YES;
+                    continue;
+                }
+            }
+            if ((INST_OP_CODE(inst) == GOTO) && (INST_DATA(inst) == (pc + 1)) && (is_skip(last_inst) == NO)) {
+                last_inst = inst;
+                pc++;
+                changed = YES;
+                continue;
+            }
+            sequence[out] = inst;
+            last_inst = inst;
+            out++;
+            pc++;
+        }
+    //
+    // re-target GOTOs/CALLs and clear unused locations
+    //
+        for (pc = 0 ; pc < out ; pc++) {
+            if (is_jump(sequence[pc]) == YES) {
+                inst = sequence[pc];
+                sequence[pc] = INSTRUCTION(INST_OP_CODE(inst), ABSOLUTE, new_addr[INST_DATA(inst)]);
+            }
+        }
+        for (pc = out ; pc < length ; pc++) {
+            sequence[pc] = END_OF_SEQUENCE;
+        }
+        length = out;
+    } while (changed == YES);
+    
+    return length;
+}
@@ -0,0 +1,12 @@
+//----------------------------------------------------------------------------
+// optimise.h
+// ==========
+//
+//----------------------------------------------------------------------------
+//
+#ifndef __optimise_H
+#define __optimise_H
+
+uint8_t optimise_sequence(uint16_t sequence[], uint8_t length);
+
+#endif /* __optimise_H */
@@ -59,6 +59,7 @@ uint8_t           activity;
             set_LED(LED_D, FLASH_ON);
             WAIT_SWITCH_RELEASED(switch_A); 
         } else {
+            MENU_IDLE;      // nothing to do until the next tick
             continue;
         }
 //
@@ -126,7 +127,7 @@ uint8_t    i;
 // initialise program sequence area
 //
     for (i=0 ; i < RAM_SEQUENCE_SIZE ; i++) {
-        RAM_sequence.uint16[i] = 0xFFFF;
+        RAM_sequence.uint16[i] = END_OF_SEQUENCE;
     }
 //
 // main loop
@@ -188,7 +189,11 @@ uint8_t    i;
         push_LED_display();       
         switch (seq_mode) {
             case PLAY :
-                run_sequence(RAM_sequence.uint16);
+                if (RAM_sequence.uint16[0] == END_OF_SEQUENCE) {   // nothing in RAM : run saved sequence
+                    run_packed_sequence(FLASH_seq_0.uint8, sizeof(FLASH_seq_0));
+                } else {
+                    run_sequence(RAM_sequence.uint16);
+                }
                 break;            
             case COLLECT :
                 input_distance_sequence();
@@ -201,6 +206,7 @@ uint8_t    i;
                 break;
             case DUMP :
                 dump_sequence();
+                dump_sequence_profile();
                 break;                                                                  
             default :
                 break;
@@ -375,66 +381,30 @@ jmp_buf   env;
                     case CMD_FORWARD    :
                         display_number(distance, 0);
                         distance =  (distance * WHEEL_CONSTANT) / 100;    // convert to wheel counts
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, WHEEL_SENSOR_CALIBRATE_SPEED); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, MOTOR_FORWARD); seq_ptr++;    
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, LEFT_MOTOR); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, SET_PARAMETER, NO_MOD, SPEED); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, WHEEL_SENSOR_CALIBRATE_SPEED); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, MOTOR_FORWARD); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, RIGHT_MOTOR); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, SET_PARAMETER, NO_MOD, SPEED); seq_ptr++;                          
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_16, IMMEDIATE, distance); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, SET_PARAMETER, NO_MOD, DISTANCE); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, EXECUTE, NO_MOD, MOVE_DISTANCE); seq_ptr++; 
+                        store_instruction(RAM_sequence.uint16, seq_ptr, SET_SPEEDS, DRIVE_FORWARD, WHEEL_SENSOR_CALIBRATE_SPEED); seq_ptr++;
+                        store_instruction(RAM_sequence.uint16, seq_ptr, DISTANCE_MOVE, NO_MOD, distance); seq_ptr++;
                         break;
                     case CMD_BACKWARD   :
                         display_number(distance, 0);  
                         distance =  (distance * WHEEL_CONSTANT) / 100;    // convert to wheel counts
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, WHEEL_SENSOR_CALIBRATE_SPEED); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, MOTOR_BACKWARD); seq_ptr++;    
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, LEFT_MOTOR); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, SET_PARAMETER, NO_MOD, SPEED); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, WHEEL_SENSOR_CALIBRATE_SPEED); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, MOTOR_BACKWARD); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, RIGHT_MOTOR); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, SET_PARAMETER, NO_MOD, SPEED); seq_ptr++;                     
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_16, IMMEDIATE, distance); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, SET_PARAMETER, NO_MOD, DISTANCE); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, EXECUTE, NO_MOD, MOVE_DISTANCE); seq_ptr++; 
+                        store_instruction(RAM_sequence.uint16, seq_ptr, SET_SPEEDS, DRIVE_BACKWARD, WHEEL_SENSOR_CALIBRATE_SPEED); seq_ptr++;
+                        store_instruction(RAM_sequence.uint16, seq_ptr, DISTANCE_MOVE, NO_MOD, distance); seq_ptr++;
                         break;
                     case CMD_SPIN_LEFT  :
                         display_number(distance, 0);
                         if (distance == 0) { distance = 0;}
                         if (distance == 45) { distance = 8;}
                         if (distance == 90) { distance = 16;}       // convert to wheel counts
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, WHEEL_SENSOR_CALIBRATE_SPEED); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, MOTOR_BACKWARD); seq_ptr++;    
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, LEFT_MOTOR); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, SET_PARAMETER, NO_MOD, SPEED); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, WHEEL_SENSOR_CALIBRATE_SPEED); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, MOTOR_FORWARD); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, RIGHT_MOTOR); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, SET_PARAMETER, NO_MOD, SPEED); seq_ptr++;                     
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_16, IMMEDIATE, distance); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, SET_PARAMETER, NO_MOD, DISTANCE); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, EXECUTE, NO_MOD, MOVE_DISTANCE); seq_ptr++; 
+                        store_instruction(RAM_sequence.uint16, seq_ptr, SET_SPEEDS, DRIVE_SPIN_LEFT, WHEEL_SENSOR_CALIBRATE_SPEED); seq_ptr++;
+                        store_instruction(RAM_sequence.uint16, seq_ptr, DISTANCE_MOVE, NO_MOD, distance); seq_ptr++;
                         break;
                     case CMD_SPIN_RIGHT :
                         display_number(distance, 0);
                         if (distance == 0) { distance = 0;}
                         if (distance == 45) { distance = 8;}
                         if (distance == 90) { distance = 16;}      // convert to wheel counts 
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, WHEEL_SENSOR_CALIBRATE_SPEED); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, MOTOR_FORWARD); seq_ptr++;    
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, LEFT_MOTOR); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, SET_PARAMETER, NO_MOD, SPEED); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, WHEEL_SENSOR_CALIBRATE_SPEED); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, MOTOR_BACKWARD); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_L8, IMMEDIATE, RIGHT_MOTOR); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, SET_PARAMETER, NO_MOD, SPEED); seq_ptr++;                     
-                        store_instruction(RAM_sequence.uint16, seq_ptr, PUSH_16, IMMEDIATE, distance); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, SET_PARAMETER, NO_MOD, DISTANCE); seq_ptr++;
-                        store_instruction(RAM_sequence.uint16, seq_ptr, EXECUTE, NO_MOD, MOVE_DISTANCE); seq_ptr++; 
+                        store_instruction(RAM_sequence.uint16, seq_ptr, SET_SPEEDS, DRIVE_SPIN_RIGHT, WHEEL_SENSOR_CALIBRATE_SPEED); seq_ptr++;
+                        store_instruction(RAM_sequence.uint16, seq_ptr, DISTANCE_MOVE, NO_MOD, distance); seq_ptr++;
                         break;
                     default : 
                         break;
@@ -541,7 +511,11 @@ sequence_mode_t   seq_mode;
         push_LED_display();       
         switch (seq_mode) {
             case PLAY :
-                run_sequence(RAM_sequence.uint16);
+                if (RAM_sequence.uint16[0] == END_OF_SEQUENCE) {   // nothing in RAM : run saved sequence
+                    run_packed_sequence(FLASH_seq_0.uint8, sizeof(FLASH_seq_0));
+                } else {
+                    run_sequence(RAM_sequence.uint16);
+                }
                 break;            
             case COLLECT :
                 input_timed_sequence();
@@ -554,6 +528,7 @@ sequence_mode_t   seq_mode;
                 break;
             case DUMP :
                 dump_sequence();
+                dump_sequence_profile();
                 break;                                                                  
             default :
                 break;
@@ -961,12 +936,16 @@ uint16_t  init_time;
 //                         termination is signaled by a duration of zero
 //
 // Notes
+//      Each command is timed from the end of the previous one so the
+//      sequence does not drift.
 //
 
 uint8_t play_sequence(void) {
 
 uint8_t  i, duration;
+delay_t  delay;
 
+    start_delay(&delay, 0);
     for (i=0 ; i < MAX_STRIP_CMDS ; i++) {
         duration = seq.strip_data[i][1];
         switch (seq.strip_data[i][0]) {
@@ -977,25 +956,29 @@ uint8_t  i, duration;
                 if (duration == 0) {           // exit if duration is zero
                     return  0;
                 }
-                DelayMs(duration * 100);          
+                next_delay(&delay, duration * 100);
+                wait_delay(&delay);
                 break;
             case CMD_SPIN_LEFT :
             case STRIP_CMD_SPIN_LEFT :
                 set_motor(LEFT_MOTOR, MOTOR_BACKWARD, STRIP_PLAY_SPIN_SPEED);
                 set_motor(RIGHT_MOTOR, MOTOR_FORWARD, STRIP_PLAY_SPIN_SPEED);
-                DelayMs(duration * 100);          
+                next_delay(&delay, duration * 100);
+                wait_delay(&delay);
                 break;
             case CMD_SPIN_RIGHT :
             case STRIP_CMD_SPIN_RIGHT :
                 set_motor(LEFT_MOTOR, MOTOR_FORWARD, STRIP_PLAY_SPIN_SPEED);
                 set_motor(RIGHT_MOTOR, MOTOR_BACKWARD, STRIP_PLAY_SPIN_SPEED);
-                DelayMs(duration * 100);          
+                next_delay(&delay, duration * 100);
+                wait_delay(&delay);
                 break;
             case CMD_FORWARD :
             case STRIP_CMD_FORWARD :
                 set_motor(LEFT_MOTOR, MOTOR_FORWARD, STRIP_PLAY_FORWARD_SPEED);
                 set_motor(RIGHT_MOTOR, MOTOR_FORWARD, STRIP_PLAY_FORWARD_SPEED);
-                DelayMs(duration * 100);            
+                next_delay(&delay, duration * 100);
+                wait_delay(&delay);
                 break;
             default :
                 return  0;
@@ -1252,19 +1235,33 @@ uint8_t   line_L, line_R, current_L, current_R, time, cmd_pt, current_cmd, new_c
 // =============
 //
 // Description
-//      1. erase specified page
-//      2. write byte stream
+//      1. optimise sequence
+//      2. erase specified page
+//      3. write packed byte stream (see 'pack_instruction')
 //
 // Notes
+//      The packed form is never longer than the 16-bit form.  The first
+//      unused entry (END_OF_SEQUENCE) ends the sequence and the rest of
+//      the page is left erased, which reads as PACKED_END.
 //  
 void save_sequence(uint8_t flash_seq_no) 
 {
-uint8_t  count;
+uint8_t   i, count, nos_bytes, packed[2];
+uint16_t  flash_ptr;
 
     if (flash_seq_no == 0) {
+        optimise_sequence(&RAM_sequence.uint16[0], RAM_SEQUENCE_SIZE);
         FlashErasePage((uint16_t)&FLASH_seq_0.uint8[0]);
-        for (count = 0 ; count < sizeof(RAM_sequence) ; count++) {
-            FlashProgramByte((uint16_t)&FLASH_seq_0.uint8[count], RAM_sequence.uint8[count]); 
+        flash_ptr = 0;
+        for (i = 0 ; i < RAM_SEQUENCE_SIZE ; i++) {
+            nos_bytes = pack_instruction(RAM_sequence.uint16[i], packed);
+            if (nos_bytes == 0) {
+                break;
+            }
+            for (count = 0 ; count < nos_bytes ; count++) {
+                FlashProgramByte((uint16_t)&FLASH_seq_0.uint8[flash_ptr], packed[count]);
+                flash_ptr++;
+            }
         }
     }
 }
@@ -1274,13 +1271,28 @@ uint8_t  count;
 // =============
 //
 // Description
+//      Unpack the FLASH byte stream into 16-bit instructions so that the
+//      sequence can be dumped or extended.  Only needed for editing : PLAY
+//      runs a saved sequence directly from FLASH.
 //
 // Notes
 //  
 void load_sequence(uint8_t flash_seq_no) 
 {
+uint8_t   i;
+uint16_t  flash_ptr;
+
     if (flash_seq_no == 0) {
-        memcpy(&RAM_sequence.uint8[0], &FLASH_seq_0.uint8[0],  (RAM_SEQUENCE_SIZE*2)); 
+        flash_ptr = 0;
+        for (i = 0 ; i < RAM_SEQUENCE_SIZE ; i++) {
+            if ((flash_ptr >= sizeof(FLASH_seq_0)) || (FLASH_seq_0.uint8[flash_ptr] == PACKED_END)) {
+                break;
+            }
+            flash_ptr += unpack_instruction(&FLASH_seq_0.uint8[flash_ptr], &RAM_sequence.uint16[i]);
+        }
+        for ( ; i < RAM_SEQUENCE_SIZE ; i++) {
+            RAM_sequence.uint16[i] = END_OF_SEQUENCE;
+        }
     }
 }
 
@@ -1298,13 +1310,61 @@ uint8_t    i;
 
     send_msg("Robot commands in RAM sequence 0\r\n");
     for (i=0 ; i < (sizeof(RAM_sequence.uint16)) ; i++) {
-        if (RAM_sequence.uint16[i] == 0xFFFF) {   // unused entries show as all 1's
+        if (RAM_sequence.uint16[i] == END_OF_SEQUENCE) {   // unused entries show as all 1's
             break;
         };
         decode_command(RAM_sequence.uint16[i]);
+        if (robot_command.op_code < NOS_INSTRUCTIONS) {
+            send_msg(inst_names[robot_command.op_code]);
+        } else {
+            send_msg("???");
+        }
+        send_msg("\t");
         send_msg(bcd(robot_command.op_code, tempstring)); send_msg("\t");
         send_msg(bcd(robot_command.modifier, tempstring)); send_msg("\t");
         send_msg(bcd(robot_command.data, tempstring));
         send_msg("\r\n");   
     }        
+}
+
+//----------------------------------------------------------------------------
+// dump_sequence_profile : dump the op-code profile of the last sequence run
+// =====================
+//
+// Description
+//      One line per op-code that was executed :
+//          name  count  total_time  max_time
+//      Times are hex TPM1 counts (50nS).  A histogram of the stack depth
+//      after each instruction follows.  The total run time (8mS ticks)
+//      shows how much of the run was spent waiting on motions and delays.
+//      Needs PROFILE_SEQUENCES to be defined in interpreter.h.
+//
+void dump_sequence_profile(void) 
+{
+#ifdef PROFILE_SEQUENCES
+uint8_t    i;
+
+    send_msg("Sequence profile (hex, 50nS counts)\r\n");
+    for (i=0 ; i < NOS_INSTRUCTIONS ; i++) {
+        if (sequence_profile[i].count == 0) {
+            continue;
+        }
+        send_msg(inst_names[i]); send_msg("\t");
+        send_hex16(sequence_profile[i].count); send_msg("\t");
+        send_hex16((uint16_t)(sequence_profile[i].total_time >> 16));
+        send_hex16((uint16_t)sequence_profile[i].total_time); send_msg("\t");
+        send_hex16(sequence_profile[i].max_time);
+        send_msg("\r\n");
+    }
+    send_msg("Stack depth 0-8\t");
+    for (i=0 ; i <= STACK_SIZE ; i++) {
+        send_hex16(stack_depth_profile[i]); send_msg(" ");
+    }
+    send_msg("\r\n");
+    send_msg("Run time (8mS ticks)\t");
+    send_hex16(profile_run_ticks);
+    send_msg("\r\n");
+#else
+    send_msg("Sequence profiling not enabled\r\n");
+#endif
 }
\ No newline at end of file
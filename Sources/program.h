@@ -21,6 +21,7 @@ uint8_t input_distance_sequence(void);
 void save_sequence(uint8_t flash_seq_no);
 void load_sequence(uint8_t flash_seq_no);
 void dump_sequence(void);
+void dump_sequence_profile(void);
 
 
 #endif /* __program_H */
\ No newline at end of file
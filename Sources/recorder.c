@@ -0,0 +1,144 @@
+//----------------------------------------------------------------------------
+//                  Robokid
+//----------------------------------------------------------------------------
+// recorder.c : timestamped ring buffer of sensor readings
+// ==========
+//
+// Description
+//      Every RECORD_PERIOD ticks the RTI stores the line, front, wheel and
+//      rear sensor values from the background a/d scan, the wheel counts
+//      and the motor states.  The oldest record is overwritten so the
+//      buffer holds the last RECORDER_SIZE records (about 0.5 seconds).
+//      Recording stops once both motors are stopped, after one record of
+//      the stop, so the buffer keeps the moments before the robot stopped
+//      (e.g. running off the line) until the motors are next started.
+//      The buffer is sent to the serial port by experiment 11.
+//
+//      RAM : RECORDER_SIZE * 13 + 4 bytes = 212 bytes
+//
+// Author                Date          Comment
+//----------------------------------------------------------------------------
+
+#include "global.h"
+
+#define   RECORD_INDEX_MASK   (RECORDER_SIZE - 1)
+#define   MOTOR_IS_STOPPED(m) (((m) == MOTOR_OFF) || ((m) == MOTOR_BRAKE))
+
+//
+// recorder data : written only by the RTI task while 'recorder_hold' is NO
+//
+sensor_record_t     records[RECORDER_SIZE];
+uint8_t             record_next;            // index of next record to write
+uint8_t             record_count;           // valid records (max RECORDER_SIZE)
+uint8_t             record_stopped;         // YES once the stop has been recorded
+uint8_t             recorder_hold;          // YES to freeze the buffer
+
+//----------------------------------------------------------------------------
+// recorder_task : store one record
+// =============
+//
+// Notes
+//      RTI task, registered by 'init_rti_tasks'.  Uses the values from the
+//      last completed background a/d scan.
+//----------------------------------------------------------------------------
+void recorder_task(void) 
+{
+sensor_record_t  *rec;
+uint8_t          i;
+
+    if (recorder_hold == YES) {
+        return;
+    }
+    if (MOTOR_IS_STOPPED(left_motor_state) && MOTOR_IS_STOPPED(right_motor_state)) {
+        if (record_stopped == YES) {
+            return;
+        }
+        record_stopped = YES;
+    } else {
+        record_stopped = NO;
+    }
+    rec = &records[record_next];
+    rec->tick = timer_ticks;
+    for (i = 0 ; i < NOS_RECORD_SENSORS ; i++) {
+        rec->sensor[i] = get_adc((a2d_channels_t)(LINE_SENSOR_L + i));
+    }
+    rec->left_count = (uint8_t)left_wheel_count;
+    rec->right_count = (uint8_t)right_wheel_count;
+    rec->motors = (uint8_t)((left_motor_state << 2) | right_motor_state);
+    record_next = (record_next + 1) & RECORD_INDEX_MASK;
+    if (record_count < RECORDER_SIZE) {
+        record_count++;
+    }
+}
+
+//----------------------------------------------------------------------------
+// clear_recorder : empty the buffer and restart recording
+// ==============
+//----------------------------------------------------------------------------
+void clear_recorder(void) 
+{
+    DISABLE_INTERRUPTS;
+    record_next = 0;
+    record_count = 0;
+    record_stopped = NO;
+    recorder_hold = NO;
+    ENABLE_INTERRUPTS;
+}
+
+//----------------------------------------------------------------------------
+// get_record : copy a record from the buffer
+// ==========
+//
+// Parameters
+//      age    : 0 for the newest record, 1 for the one before, ...
+//      record : pointer to structure to receive the copy
+//
+// Results
+//      OK, or FAIL if there are fewer than 'age + 1' records
+//----------------------------------------------------------------------------
+uint8_t get_record(uint8_t age, sensor_record_t *record) 
+{
+uint8_t   status;
+
+    status = FAIL;
+    DISABLE_INTERRUPTS;
+    if (age < record_count) {
+        *record = records[(record_next - 1 - age) & RECORD_INDEX_MASK];
+        status = OK;
+    }
+    ENABLE_INTERRUPTS;
+    return status;
+}
+
+//----------------------------------------------------------------------------
+// dump_recorder : send the buffer to the serial port, oldest record first
+// =============
+//
+// Notes
+//      One CSV line per record :
+//          tick(hex), 8 sensor values, left count, right count, left motor, right motor
+//      Recording is held while the buffer is sent.
+//----------------------------------------------------------------------------
+void dump_recorder(void) 
+{
+sensor_record_t  rec;
+uint8_t          age, i;
+
+    recorder_hold = YES;
+    send_msg("tick,LL,LR,FL,FC,FR,WL,WR,RR,lcnt,rcnt,lmot,rmot\r\n");
+    for (age = record_count ; age > 0 ; age--) {
+        if (get_record((uint8_t)(age - 1), &rec) == FAIL) {
+            break;
+        }
+        send_hex16(rec.tick);
+        for (i = 0 ; i < NOS_RECORD_SENSORS ; i++) {
+            send_msg(","); send_msg(bcd(rec.sensor[i], tempstring));
+        }
+        send_msg(","); send_msg(bcd(rec.left_count, tempstring));
+        send_msg(","); send_msg(bcd(rec.right_count, tempstring));
+        send_msg(","); send_msg(bcd((rec.motors >> 2), tempstring));
+        send_msg(","); send_msg(bcd((rec.motors & 0x03), tempstring));
+        send_msg("\r\n");
+    }
+    recorder_hold = NO;
+}
@@ -0,0 +1,30 @@
+//----------------------------------------------------------------------------
+// recorder.h
+// ==========
+//
+//----------------------------------------------------------------------------
+//
+#ifndef __recorder_H
+#define __recorder_H
+
+#define   RECORD_PERIOD       4       // ticks between records (32mS)
+#define   RECORDER_SIZE       16      // records : must be a power of 2
+#define   NOS_RECORD_SENSORS  8
+
+//
+// one record (13 bytes).  Wheel counts are the low bytes of the counters,
+// motor states are packed as (left << 2) | right.
+//
+typedef struct {
+    uint16_t    tick;                             // 'timer_ticks' (never cleared)
+    uint8_t     sensor[NOS_RECORD_SENSORS];       // LINE_SENSOR_L .. REAR_SENSOR
+    uint8_t     left_count, right_count;
+    uint8_t     motors;
+} sensor_record_t;
+
+void recorder_task(void);
+void clear_recorder(void);
+uint8_t get_record(uint8_t age, sensor_record_t *record);
+void dump_recorder(void);
+
+#endif /* __recorder_H */
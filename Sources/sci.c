@@ -43,8 +43,10 @@ char sci_rx_byte()
 char rec_char;
 
     SCI1C2_RE = 1;           	// enable Rx
-    while(!SCI1S1_RDRF)         
-        ;                       // wait for character
+    while(!SCI1S1_RDRF) {       // wait for character
+        SCI1C2_RIE = 1;         // wake on received character
+        CPU_IDLE;
+    }
     rec_char = SCI1D;        	// get received character
     SCI1C2_RE = 0;              // disable Rx
     return rec_char;			 			
@@ -91,6 +93,19 @@ char temp;
     return number_str;      
 }
 
+//***********************************************************************
+//** Function:      send_hex16
+//** Description:   Send a 16-bit value as 4 hex characters
+//** Parameters:    uint16_t value - value to send
+//** Returns:       None
+//*********************************************************************** 
+void send_hex16(uint16_t value){
+char number_str[3];
+
+    send_msg(HexToAsc((char)(value >> 8), number_str));
+    send_msg(HexToAsc((char)value, number_str));
+}
+
 void * HexToBin(char byte, char number_str[]){
   char n;
   for (n=0;n<8;n++){
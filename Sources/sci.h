@@ -8,6 +8,7 @@ extern char sci_rx_byte(void);
 extern void send_msg(char msg[]);
 extern void * HexToAsc(char byte, char *number_str);
 extern void * HexToBin(char byte, char *number_str);
+extern void send_hex16(uint16_t value);
 extern void * bcd(char byte, char number_str[]);
 
 #endif /* __sci_H */
\ No newline at end of file
@@ -57,6 +57,7 @@ uint8_t   activity;
             set_LED(LED_D, FLASH_ON);
             WAIT_SWITCH_RELEASED(switch_A); 
         } else {
+            MENU_IDLE;      // nothing to do until the next tick
             continue;
         }
 //
@@ -105,13 +106,39 @@ uint8_t   activity;
 
 #define   SKETCH_MODE_0_TIME_OUT   50
 
+//----------------------------------------------------------------------------
+// spiral_step : hold the motor speeds for one step of the spiral
+// ===========
+//
+// Parameters
+//      step_time : length of step in mS
+//
+// Results
+//      YES if the front centre sensor detected a bump during the step
+//
+static uint8_t spiral_step(uint16_t step_time) 
+{
+delay_t    step;
+
+    start_delay(&step, step_time);
+    while (delay_expired(&step) == NO) {
+        if (get_adc(FRONT_SENSOR_C) < SENSE_LOW ) {       // check for bump
+            return YES;
+        }
+        CPU_IDLE;
+    }
+    return NO;
+}
+
 uint8_t run_sketch_mode_0(void) 
 {
 uint8_t       ad_value, spiral_mode, i; 
 mode_state_t  state;
-uint16_t      time, spiral_update_time; 
+uint16_t      spiral_update_time; 
+timer_id_t    timeout;
 
     state = MODE_INIT;
+    timeout = alloc_timer(NULL);
     spiral_update_time = DEFAULT_SPIRAL_UPDATE_TIME;
     set_LED(LED_A, FLASH_ON);
     set_LED(LED_B, FLASH_ON);
@@ -126,8 +153,7 @@ uint16_t      time, spiral_update_time;
 //  check for timeout if in RUNNING state
 //
         if (state == MODE_RUNNING) {   
-            GET_TIMER16(time);
-            if (time > SKETCH_MODE_0_TIME_OUT ) {
+            if (timer_expired(timeout) == YES) {
                 state = MODE_INIT;
                 vehicle_stop();
                 continue;
@@ -151,6 +177,7 @@ uint16_t      time, spiral_update_time;
             vehicle_stop();
             SOUND_EXIT_SELECTION;
             WAIT_SWITCH_RELEASED(switch_C);
+            free_timer(timeout);
             return 0;
         }  
 //
@@ -160,7 +187,7 @@ uint16_t      time, spiral_update_time;
         if (state == MODE_INIT) {
             if (switch_A == PRESSED) {            //  go to RUN state              
                 state = MODE_RUNNING;
-                CLR_TIMER16;                      // reset timeout timer
+                start_timer(timeout, SKETCH_MODE_0_TIME_OUT, 0);    // start timeout timer
                 WAIT_SWITCH_RELEASED(switch_A); 
             } else {
                 continue;                         // back to begining of FOREVER loop
@@ -195,9 +222,9 @@ uint16_t      time, spiral_update_time;
             } else {
                 set_motor(RIGHT_MOTOR, MOTOR_BACKWARD, i);
             }
-            DelayMs(spiral_update_time);
-            if (get_adc(FRONT_SENSOR_C) < SENSE_LOW ) {       // check for bump
+            if (spiral_step(spiral_update_time) == YES) {       // bump
                 vehicle_stop ();
+                free_timer(timeout);
                 return 0;
             }
         }        
@@ -207,13 +234,14 @@ uint16_t      time, spiral_update_time;
             } else {
                 set_motor(RIGHT_MOTOR, MOTOR_FORWARD, i);
             }
-            DelayMs(spiral_update_time);
-            if (get_adc(FRONT_SENSOR_C) < SENSE_LOW ) {        // check for bump
+            if (spiral_step(spiral_update_time) == YES) {       // bump
                 vehicle_stop ();
+                free_timer(timeout);
                 return 0;
             } 
         }
         vehicle_stop ();
+        free_timer(timeout);
         return 0;
     }
 }
@@ -304,7 +332,6 @@ mode_state_t    state;
         if (state == MODE_INIT) {
             if (switch_A == PRESSED) {            //  go to RUN state              
                 state = MODE_RUNNING;
-                CLR_TIMER16;                      // reset timeout timer
                 WAIT_SWITCH_RELEASED(switch_A); 
             } else {
                 continue;                         // back to begining of FOREVER loop
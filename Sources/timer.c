@@ -0,0 +1,280 @@
+//----------------------------------------------------------------------------
+//                  Robokid
+//----------------------------------------------------------------------------
+// timer.c : software timers run from the 8mS RTI
+// =======
+//
+// Description
+//      A fixed pool of one-shot and periodic timers.  Running timers are
+//      kept in a list ordered by expiry time so each tick the RTI only
+//      compares the head of the list with the tick count.  On expiry a
+//      timer sets its TIMER_EXPIRED flag (read by 'timer_expired') and
+//      calls its callback, if any.
+//
+//      The timers count their own ticks, so unlike CLR_TIMER16 starting a
+//      timer does not upset anyone else's timing.  Times are compared as
+//      signed differences so the tick count may roll over, which limits
+//      times and periods to MAX_TIMER_TICKS.
+//
+// Notes
+//      Callbacks run in the RTI with interrupts masked and must be short.
+//      The functions in this file save and restore the interrupt mask, so
+//      callbacks (and other interrupt routines) may call them, e.g. to
+//      start another timer or free their own.
+//
+// Author                Date          Comment
+//----------------------------------------------------------------------------
+
+#include "global.h"
+
+//
+// timer data
+//
+soft_timer_t    soft_timers[MAX_SOFT_TIMERS];
+uint8_t         timer_head;                 // running timer due first
+uint16_t        timer_ticks;                // never cleared
+
+//----------------------------------------------------------------------------
+// link_timer : insert a timer into the running list in expiry order
+// ==========
+//
+// Notes
+//      Called with interrupts masked.  A timer goes after others with the
+//      same expiry time so timers due together fire in the order started.
+//
+static void link_timer(timer_id_t id) 
+{
+uint8_t    *link;
+int16_t    remaining;
+
+    remaining = (int16_t)(soft_timers[id].expiry - timer_ticks);
+    link = &timer_head;
+    while ((*link != NO_TIMER) && 
+           ((int16_t)(soft_timers[*link].expiry - timer_ticks) <= remaining)) {
+        link = &soft_timers[*link].next;
+    }
+    soft_timers[id].next = *link;
+    *link = id;
+    soft_timers[id].flags |= TIMER_RUNNING;
+}
+
+//----------------------------------------------------------------------------
+// unlink_timer : remove a timer from the running list
+// ============
+//
+// Notes
+//      Called with interrupts masked.
+//
+static void unlink_timer(timer_id_t id) 
+{
+uint8_t    *link;
+
+    if ((soft_timers[id].flags & TIMER_RUNNING) == 0) {
+        return;
+    }
+    link = &timer_head;
+    while (*link != id) {
+        link = &soft_timers[*link].next;
+    }
+    *link = soft_timers[id].next;
+    soft_timers[id].flags &= ~TIMER_RUNNING;
+}
+
+//----------------------------------------------------------------------------
+// init_timers : free all timers
+// ===========
+//
+// Notes
+//      Called during initialisation before interrupts are enabled.
+//
+void init_timers(void) 
+{
+uint8_t   i;
+
+    for (i = 0 ; i < MAX_SOFT_TIMERS ; i++) {
+        soft_timers[i].flags = 0;
+    }
+    timer_head = NO_TIMER;
+    timer_ticks = 0;
+}
+
+//----------------------------------------------------------------------------
+// timer_task : count a tick and run any timers that are due
+// ==========
+//
+// Notes
+//      RTI task, registered by 'init_rti_tasks'.  The running list is read
+//      again after each callback, so a callback may start, stop or free
+//      timers, including its own.
+//
+void timer_task(void) 
+{
+timer_id_t   id;
+
+    timer_ticks++;
+    while (timer_head != NO_TIMER) {
+        id = timer_head;
+        if ((int16_t)(timer_ticks - soft_timers[id].expiry) < 0) {
+            break;
+        }
+        timer_head = soft_timers[id].next;
+        soft_timers[id].flags &= ~TIMER_RUNNING;
+        soft_timers[id].flags |= TIMER_EXPIRED;
+        if (soft_timers[id].period != 0) {
+            soft_timers[id].expiry += soft_timers[id].period;
+            link_timer(id);
+        }
+        if (soft_timers[id].callback != NULL) {
+            soft_timers[id].callback();
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+// alloc_timer : take a timer from the pool
+// ===========
+//
+// Parameters
+//      callback : function called on expiry, or NULL to only set the flag
+//
+// Results
+//      timer id, or NO_TIMER if the pool is empty.  The timer is stopped.
+//
+// Notes
+//      The other timer functions ignore NO_TIMER, so a mode that cannot
+//      get a timer runs without its timeout.
+//
+timer_id_t alloc_timer(timer_fn_t callback) 
+{
+timer_id_t   id;
+uint8_t      ccr;
+
+    SAVE_AND_DISABLE_INTERRUPTS(ccr);
+    for (id = 0 ; id < MAX_SOFT_TIMERS ; id++) {
+        if (soft_timers[id].flags == 0) {
+            soft_timers[id].callback = callback;
+            soft_timers[id].flags = TIMER_ALLOCATED;
+            break;
+        }
+    }
+    RESTORE_INTERRUPTS(ccr);
+    if (id == MAX_SOFT_TIMERS) {
+        return NO_TIMER;
+    }
+    return id;
+}
+
+//----------------------------------------------------------------------------
+// free_timer : stop a timer and return it to the pool
+// ==========
+//
+void free_timer(timer_id_t id) 
+{
+uint8_t   ccr;
+
+    if (id >= MAX_SOFT_TIMERS) {
+        return;
+    }
+    SAVE_AND_DISABLE_INTERRUPTS(ccr);
+    unlink_timer(id);
+    soft_timers[id].flags = 0;
+    RESTORE_INTERRUPTS(ccr);
+}
+
+//----------------------------------------------------------------------------
+// start_timer : (re)start a timer
+// ===========
+//
+// Parameters
+//      id     : timer from 'alloc_timer'
+//      ticks  : 8mS ticks to first expiry (1 -> MAX_TIMER_TICKS)
+//      period : ticks between later expiries (1 -> MAX_TIMER_TICKS), or 0
+//               for a one-shot timer
+//
+// Notes
+//      Clears the TIMER_EXPIRED flag.  A running timer is restarted.
+//      Larger values of 'ticks' and 'period' are clamped to MAX_TIMER_TICKS
+//      to keep the signed wrap-around compare of expiry times valid.
+//
+void start_timer(timer_id_t id, uint16_t ticks, uint16_t period) 
+{
+uint8_t   ccr;
+
+    if (id >= MAX_SOFT_TIMERS) {
+        return;
+    }
+    if (ticks == 0) {
+        ticks = 1;
+    }
+    if (ticks > MAX_TIMER_TICKS) {
+        ticks = MAX_TIMER_TICKS;
+    }
+    if (period > MAX_TIMER_TICKS) {
+        period = MAX_TIMER_TICKS;
+    }
+    SAVE_AND_DISABLE_INTERRUPTS(ccr);
+    unlink_timer(id);
+    soft_timers[id].flags &= ~TIMER_EXPIRED;
+    soft_timers[id].expiry = timer_ticks + ticks;
+    soft_timers[id].period = period;
+    link_timer(id);
+    RESTORE_INTERRUPTS(ccr);
+}
+
+//----------------------------------------------------------------------------
+// stop_timer : stop a timer without freeing it
+// ==========
+//
+void stop_timer(timer_id_t id) 
+{
+uint8_t   ccr;
+
+    if (id >= MAX_SOFT_TIMERS) {
+        return;
+    }
+    SAVE_AND_DISABLE_INTERRUPTS(ccr);
+    unlink_timer(id);
+    RESTORE_INTERRUPTS(ccr);
+}
+
+//----------------------------------------------------------------------------
+// timer_expired : test and clear the expiry flag of a timer
+// =============
+//
+// Results
+//      YES if the timer has expired since it was started or last tested
+//
+uint8_t timer_expired(timer_id_t id) 
+{
+uint8_t   status, ccr;
+
+    if (id >= MAX_SOFT_TIMERS) {
+        return NO;
+    }
+    status = NO;
+    SAVE_AND_DISABLE_INTERRUPTS(ccr);
+    if ((soft_timers[id].flags & TIMER_EXPIRED) != 0) {
+        soft_timers[id].flags &= ~TIMER_EXPIRED;
+        status = YES;
+    }
+    RESTORE_INTERRUPTS(ccr);
+    return status;
+}
+
+//----------------------------------------------------------------------------
+// get_timer_ticks : read the free running timer tick count
+// ===============
+//
+// Notes
+//      Unlike 'tick_count_16' this count is never cleared.
+//
+uint16_t get_timer_ticks(void) 
+{
+uint16_t   ticks;
+uint8_t    ccr;
+
+    SAVE_AND_DISABLE_INTERRUPTS(ccr);
+    ticks = timer_ticks;
+    RESTORE_INTERRUPTS(ccr);
+    return ticks;
+}
@@ -0,0 +1,47 @@
+//----------------------------------------------------------------------------
+// timer.h
+// =======
+//
+//----------------------------------------------------------------------------
+//
+#ifndef __timer_H
+#define __timer_H
+
+#define   MAX_SOFT_TIMERS     8
+#define   NO_TIMER            0xFF          // 'alloc_timer' failed / end of list
+#define   MAX_TIMER_TICKS     0x7FFF        // longest time or period (262 seconds)
+
+typedef uint8_t     timer_id_t;
+typedef void        (*timer_fn_t)(void);
+
+//
+// timer states (bits of 'flags')
+//
+#define   TIMER_ALLOCATED     0x01
+#define   TIMER_RUNNING       0x02
+#define   TIMER_EXPIRED       0x04
+
+typedef struct {
+    timer_fn_t  callback;       // called from the RTI on expiry, NULL for none
+    uint16_t    expiry;         // 'timer_ticks' value at expiry
+    uint16_t    period;         // 0 for a one-shot timer
+    uint8_t     next;           // next running timer in expiry order
+    uint8_t     flags;
+} soft_timer_t;
+
+//
+// 8mS ticks since start-up, never cleared.  Interrupt routines may read it
+// directly; other code uses 'get_timer_ticks'.
+//
+extern  uint16_t    timer_ticks;
+
+void init_timers(void);
+void timer_task(void);
+timer_id_t alloc_timer(timer_fn_t callback);
+void free_timer(timer_id_t id);
+void start_timer(timer_id_t id, uint16_t ticks, uint16_t period);
+void stop_timer(timer_id_t id);
+uint8_t timer_expired(timer_id_t id);
+uint16_t get_timer_ticks(void);
+
+#endif /* __timer_H */
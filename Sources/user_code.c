@@ -82,6 +82,8 @@ void user_init(void) {
     disable_wheel_count();
     
     switch_A = RELEASED; switch_B = RELEASED; switch_C = RELEASED; switch_D = RELEASED;
+    switch_ABCD = ALL_RELEASED;
+    debounced_state = 0xFF;
 
     state_of_vehicle = STOPPED;
     left_motor_state = MOTOR_OFF;
@@ -102,7 +104,9 @@ void user_init(void) {
     tick_count_8 = 0;
     tick_count_16 = 0;
     second_count = 0;
-    tick_for_second_count = TICKS_IN_ONE_SECOND;
+    init_timers();
+    init_clock();
+    init_rti_tasks();
 //
 // set wheel sensor initial conditions
 //    
@@ -122,9 +126,6 @@ void user_init(void) {
     } else {
         right_wheel_sensor_value = WHITE;
     }
-          
-    left_speed_index = 0;     // index to left speed circular buffer
-    right_speed_index = 0;    // index to right speed circular buffer
     
     display_init();
 //
@@ -153,11 +154,11 @@ void user_init(void) {
 // ==============
 //
 // Notes
-//      Uses background counter to generate some randomness
+//      Low bit of 'get_random_byte'
 //
 uint8_t get_random_bit(void) {
 
-    return  (tick_count_8 & 0x01);
+    return  (get_random_byte() & 0x01);
 }
 
 //----------------------------------------------------------------------------
@@ -165,11 +166,15 @@ uint8_t get_random_bit(void) {
 // ===============
 //
 // Notes
-//      Use low 8-bits of background 8mS tick counter
+//      Low bits of the microsecond clock.  These change every uS, so the
+//      result depends on the exact time of the call rather than on the 
+//      8mS tick.
 //
 uint8_t get_random_byte(void) {
+uint32_t  time;
 
-    return  tick_count_8;
+    time = get_time_us();
+    return  (uint8_t)(time ^ (time >> 8));
 }
 
 //----------------------------------------------------------------------------
@@ -324,26 +329,26 @@ uint16_t  pulse_count, period_count ;
             case MOTOR_OFF :        // set FREEWHEEL condition
                 setReg16(TPM1C2V, 0);     // set LOW on RM_PWM1 and RM_PWM2
                 setReg16(TPM1C3V, 0);
-                left_motor_state = MOTOR_OFF;
+                right_motor_state = MOTOR_OFF;
                 break;
             case MOTOR_FORWARD :    // set LOW on RM_PWM2 and pwm on LM_PWM1
                 setReg16(TPM1C2V, period_count);      // set pwm on RM_PWM1
                 setReg16(TPM1C3V, pulse_count);       // set LOW on RM_PWM2
-                left_motor_state = MOTOR_FORWARD;
+                right_motor_state = MOTOR_FORWARD;
                 break;
             case MOTOR_BACKWARD :   // set LOW on RM_PWM1 and RM_PWM2
                 setReg16(TPM1C2V, pulse_count);       // set LOW on RM_PWM1
                 setReg16(TPM1C3V, period_count);      // set pwm on RM_PWM2
-                left_motor_state = MOTOR_BACKWARD;
+                right_motor_state = MOTOR_BACKWARD;
                 break;
             case MOTOR_BRAKE :      // set BRAKE condition
                 setReg16(TPM1C2V, period_count);     // set HIGH on RM_PWM1 and RM_PWM2
                 setReg16(TPM1C3V, period_count);
-                left_motor_state = MOTOR_BRAKE;
+                right_motor_state = MOTOR_BRAKE;
                 break;
         }
     }
-    setReg8(TPM1SC, (TPM_OVFL_INT_DIS | TPM_EDGE_ALIGN | TPM_BUSCLK | TPM_PRESCAL_DIV1));  
+    setReg8(TPM1SC, (TPM_OVFL_INT_EN | TPM_EDGE_ALIGN | TPM_BUSCLK | TPM_PRESCAL_DIV1));  
     set_vehicle_state(); 
 }
 
@@ -498,12 +503,16 @@ uint8_t   value_1, value_2;
 //     On power-on the experiment mode is not available.  This prevents the pupils putting
 //     the robot into special modes.  To get the system to include the experiment mode (r5)
 //     in the 'r' options press the D switch for longer than 5 seconds. 
+//
+//     Switches are read from the switch event queue.  The queue is flushed when a mode
+//     returns as modes may still poll the switch levels directly.
 //       
 void run_bot(void) {
 
 static sys_modes_t  mode, last_mode;
-uint8_t   ad_value;
-uint16_t  ticks;
+uint8_t          ad_value;
+switch_event_t   event;
+timer_id_t       wait_timer;
 
     user_init();
 //
@@ -529,24 +538,33 @@ uint16_t  ticks;
 //  2. battery level low -> show battery level message for several seconds then show "robot"
 //  3. battery level OK -> continue as normal and show "robot" string
 //    
-    if (get_adc(BATTERY_VOLTS) < CRITICAL_BATTERY_THRESHOLD) {
+    if (get_adc10(BATTERY_VOLTS) < (CRITICAL_BATTERY_THRESHOLD << 2)) {     // 10-bit reading
         load_display(&recharge);
         play_tune(&snd_battery_recharge);
-        HANG;                        //  insufficient power to run the motors reliably
+        HANG {                       //  insufficient power to run the motors reliably
+            MENU_IDLE;
+        }
     }
-    if (get_adc(BATTERY_VOLTS) < LOW_BATTERY_THRESHOLD) {
+    if (get_adc10(BATTERY_VOLTS) < (LOW_BATTERY_THRESHOLD << 2)) {
         load_display(&bat_lo);
         play_tune(&snd_battery_low);
-        DelayMs(20000);
+        wait_timer = alloc_timer(NULL);
+        start_timer(wait_timer, LOW_BATTERY_MESSAGE_TIME, 0);
+        IDLE_WHILE((wait_timer != NO_TIMER) && (timer_expired(wait_timer) == NO));
+        free_timer(wait_timer);
     }    
     load_display(&robot);
 //
 // user must press switch A to continue
 //
     set_LED(LED_A, FLASH_ON);
+    flush_switch_events();
     FOREVER {
-        if (switch_A == PRESSED) {
-            WAIT_SWITCH_RELEASED(switch_A);
+        if (get_switch_event(&event) == NO) {
+            MENU_IDLE;               // nothing to do until the next tick
+            continue;
+        }
+        if ((event.switch_bit == SWITCH_A_BIT) && (event.type == SW_EVENT_RELEASE)) {
             break;
         }
     }
@@ -561,11 +579,20 @@ uint16_t  ticks;
 // check for GO or mode increment button
 //        
     FOREVER {
-        if (switch_A == PRESSED) {    // GO button
-            clr_LED(LED_A);
-            clr_LED(LED_D);       
-            show_dual_chars('r', ('0'+ mode), 0);
-            WAIT_SWITCH_RELEASED(switch_A);     // wait until button returns to quiescent state
+        if (get_switch_event(&event) == NO) {
+            MENU_IDLE;               // nothing to do until the next tick
+            continue;
+        }
+        if (event.switch_bit == SWITCH_A_BIT) {    // GO button
+            if (event.type == SW_EVENT_PRESS) {
+                clr_LED(LED_A);
+                clr_LED(LED_D);       
+                show_dual_chars('r', ('0'+ mode), 0);
+                continue;
+            }
+            if (event.type != SW_EVENT_RELEASE) {    // wait until button returns to quiescent state
+                continue;
+            }
             play_tune(&snd_goto_selection);
             switch (mode){
                 case JOYSTICK_MODE :                             // done
@@ -600,22 +627,21 @@ uint16_t  ticks;
             }
             R_MODE_LEDS;
             show_dual_chars('r', ('0' + mode), (A_TO_FLASH | 10));
+            flush_switch_events();
         }
 //
-//  check for mode change button
+//  check for mode change button : held for more than 5 seconds adds experiment mode
 //
-        
-        if (switch_D == PRESSED) {
-            CLR_TIMER16;                        // clear 16-bit 8mS tick counter
-            mode++; 
-            if (mode > last_mode) {
-                mode = 0;
-            }           
-            show_dual_chars('r', ('0' + mode), (A_TO_FLASH | 10));
-            SOUND_NEXT_SELECTION;
-            WAIT_SWITCH_RELEASED(switch_D);     // wait until button returns to quiescent state 
-            GET_TIMER16(ticks);                 // read 16-bit 8mS tick counter
-            if (ticks > (5 * TICKS_IN_ONE_SECOND)) {     // button press time > 5 seconds
+        if (event.switch_bit == SWITCH_D_BIT) {
+            if (event.type == SW_EVENT_PRESS) {
+                mode++; 
+                if (mode > last_mode) {
+                    mode = 0;
+                }           
+                show_dual_chars('r', ('0' + mode), (A_TO_FLASH | 10));
+                SOUND_NEXT_SELECTION;
+            }
+            if ((event.type == SW_EVENT_LONG_PRESS) && (event.duration >= (5 * TICKS_IN_ONE_SECOND))) {
                 last_mode = EXPERIMENT_MODE;
             }
         }  
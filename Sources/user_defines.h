@@ -41,12 +41,12 @@
 #define     SOUND_READ_POTS          play_tune(&snd_read_pots);
 #define     SOUND_SYSTEM_INIT        play_tune(&snd_system_init);
 //
-// macros to read debounced switch states
+// macros to read debounced switch states : the CPU idles until the debounce task changes them
 //
-#define     WAIT_SWITCH_RELEASED(switch_n)      while((switch_n) == PRESSED);
-#define     WAIT_SWITCH_PRESSED(switch_n)       while((switch_n) == RELEASED);
-#define     WAIT_ANY_SWITCH_PRESSED             while(switch_ABCD == ALL_RELEASED);
-#define     WAIT_ALL_SWITCHES_RELEASED          while(switch_ABCD != ALL_RELEASED);
+#define     WAIT_SWITCH_RELEASED(switch_n)      IDLE_WHILE((switch_n) == PRESSED)
+#define     WAIT_SWITCH_PRESSED(switch_n)       IDLE_WHILE((switch_n) == RELEASED)
+#define     WAIT_ANY_SWITCH_PRESSED             IDLE_WHILE(switch_ABCD == ALL_RELEASED)
+#define     WAIT_ALL_SWITCHES_RELEASED          IDLE_WHILE(switch_ABCD != ALL_RELEASED)
 #define     PROMPT_SWITCH_A    set_LED(LED_A, FLASH_ON);WAIT_SWITCH_PRESSED(switch_A);WAIT_SWITCH_RELEASED(switch_A);clr_LED(LED_A);
 
 #define     BLACK            0
@@ -66,17 +66,54 @@
 #define  L_MODE_LEDS    set_LED(LED_A, FLASH_ON); clr_LED(LED_B); set_LED(LED_C, FLASH_ON); set_LED(LED_D, FLASH_ON); 
 
 //
-// macros to access the 16-bit tick counter : protect by disabling/enabling interrupts
+// interrupt masking.  With TIME_INTERRUPTS defined the longest time spent
+// between DISABLE_INTERRUPTS and ENABLE_INTERRUPTS is recorded along with
+// the ISR execution times (see 'interrupt.c' and experiment 10)
 //
-#define  CLR_TIMER16              { asm sei; tick_count_16 = 0; asm cli; }
-#define  GET_TIMER16(variable)    { asm sei; (variable) = tick_count_16; asm cli; }
+//#define  TIME_INTERRUPTS          // time ISRs and masked periods (about 90 bytes of RAM)
 
+#ifdef TIME_INTERRUPTS
+#define  DISABLE_INTERRUPTS       { asm sei; mask_start_time = TPM1CNT; }
+#define  ENABLE_INTERRUPTS        { end_masked_period(); asm cli; }
+#else
 #define  DISABLE_INTERRUPTS       { asm sei;}
 #define  ENABLE_INTERRUPTS        { asm cli;}
+#endif
+//
+// masking that may also be used from an ISR : the CCR is saved in 'ccr' (a
+// uint8_t) and restored, so the I bit is left as it was rather than cleared.
+// These periods are not timed by TIME_INTERRUPTS.
+//
+#define  SAVE_AND_DISABLE_INTERRUPTS(ccr)  { asm tpa; asm sta ccr; asm sei; }
+#define  RESTORE_INTERRUPTS(ccr)           { asm lda ccr; asm tap; }
+//
+// macros to access the 16-bit tick counter : protect by disabling/enabling interrupts
+// The counter is shared, so new timeouts should use the timers in 'timer.c'
+//
+#define  CLR_TIMER16              { DISABLE_INTERRUPTS; tick_count_16 = 0; ENABLE_INTERRUPTS; }
+#define  GET_TIMER16(variable)    { DISABLE_INTERRUPTS; (variable) = tick_count_16; ENABLE_INTERRUPTS; }
+
+#define  CPU_WAIT                 { asm wait;}    // sleep until next interrupt (enables interrupts)
+//
+// low-power idle.  Waiting loops stop the CPU with CPU_IDLE and test their
+// condition again after each interrupt.  The TPM1 overflow (200uS), RTI
+// (8mS), ADC, IRQ, KBI and SCI receive interrupts all wake the CPU.  The
+// menus use MENU_IDLE, which stops the TPM1 overflow interrupt while the
+// motors are stopped and sleeps until the next RTI (see 'menu_idle').
+// With MEASURE_IDLE defined the time spent idle is recorded (see 'clock.c'
+// and experiment 12).  Not for use with interrupts masked.
+//
+//#define  MEASURE_IDLE             // record time spent idle (16 bytes of RAM)
 
-#define  CLEAR_AD_WHEEL_COUNTERS  { asm sei; left_wheel_count = 0; right_wheel_count = 0; asm cli; }
+#ifdef MEASURE_IDLE
+#define  CPU_IDLE                 cpu_idle();
+#else
+#define  CPU_IDLE                 CPU_WAIT
+#endif
+#define  IDLE_WHILE(condition)    while (condition) { CPU_IDLE; }
+#define  MENU_IDLE                menu_idle();
 
-#define  INSTRUCTION(OP_CODE, MODIFIER, DATA)  ((((OP_CODE)<<8)&0x3F00) | (((MODIFIER)<<8)&0xC000) | (((DATA))&0x00FF))    
+#define  CLEAR_AD_WHEEL_COUNTERS  { DISABLE_INTERRUPTS; left_wheel_count = 0; right_wheel_count = 0; ENABLE_INTERRUPTS; }
 
 //----------------------------------------------------------------------------
 // commands from reading strip scans
@@ -145,7 +182,7 @@
 #define     NO_LINE                    60
 #define     BLACK_WHITE_THRESHOLD     120     // lower for white, higher for black
 
-#define     SWITCH_SAMPLES     3     // number of samples to debounce push switches
+#define     SWITCH_SAMPLES     4     // samples to debounce push switches (fixed by 2-bit vertical counter)
 
 #define     DEFAULT_SPEED             60    // 60% full speed
 #define     DEFAULT_LINE_BUMP_SPEED   60    // %
@@ -164,10 +201,11 @@
 
 #define     MAX_SEQ           64
 
-#define     MAX_EXPERIMENT     9
+#define     MAX_EXPERIMENT    13
 
 #define     CRITICAL_BATTERY_THRESHOLD  150
 #define     LOW_BATTERY_THRESHOLD       170     // 4.4v level
+#define     LOW_BATTERY_MESSAGE_TIME    (20 * TICKS_IN_ONE_SECOND)
 
 #define     MAX_STRIP_CMDS     30
 
@@ -218,6 +256,12 @@
 #define     RELEASED       1
 #define     ALL_RELEASED   0b00111100 
 
+#define     SWITCH_A_BIT   0b00000100     // port C bits of the switches
+#define     SWITCH_B_BIT   0b00001000
+#define     SWITCH_D_BIT   0b00010000
+#define     SWITCH_C_BIT   0b00100000
+#define     NOS_SWITCHES   4
+
 //----------------------------------------------------------------------------
 // error codes
 //
@@ -386,7 +430,7 @@ typedef enum
 } experiment_mode_t;
 
 #define   FIRST_EXPERIMENT_MODE  CYCLE_DISPLAYS
-#define   LAST_EXPERIMENT_MODE   9
+#define   LAST_EXPERIMENT_MODE   13
 
 
 #define   RAM_SEQUENCE_SIZE    100
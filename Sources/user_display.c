@@ -101,7 +101,7 @@ void show_dual_chars(char B_char, char A_char, uint8_t mode)
     } else {
         robot_display.data_B[1] = char_to_7seg[B_char];
     }    
-    robot_display.shift_rate = (mode & 0x3F) << 3;
+    robot_display.shift_rate = mode & 0x3F;        // 64mS units
     robot_display.char_ptr = 0;
     return;
 }
@@ -178,7 +178,7 @@ uint8_t  chr_count;
     }
     temp_display.data_A[chr_count] = CHAR_CLR;
     temp_display.char_count = chr_count + 1;
-    temp_display.shift_rate = 80;
+    temp_display.shift_rate = 10;                   // 640mS
 //
 //  now copy temp to actual display data structure
 //
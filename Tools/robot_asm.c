@@ -0,0 +1,584 @@
+//----------------------------------------------------------------------------
+//
+//                  Robokid
+//
+//----------------------------------------------------------------------------
+// robot_asm.c : host assembler/disassembler for robot sequences
+// ===========
+//
+// Description
+//      Command line tool run on the development PC (not on the robot).
+//
+//          robot_asm [-o file] prog.rbt        assemble to 16-bit words
+//          robot_asm -s [-o file] prog.rbt     assemble to an S19 fragment
+//          robot_asm -d [-o file] dump.txt     disassemble
+//
+//      Assembled words are written as a C initialiser suitable for a table
+//      such as 'program_a'.  The S19 fragment holds the compact FLASH form of
+//      the sequence (see 'pack_instruction') at FLASH_AREA2 (Project.prm),
+//      the address of 'FLASH_seq_0'.
+//
+//      The disassembler reads hex words (e.g. "0x0E28" or "0E28"), the
+//      lines printed by 'dump_sequence', or S1 records of a packed sequence
+//      and prints them in the 'dump_sequence' format
+//
+//          name <tab> op-code <tab> modifier <tab> data
+//
+//      which the assembler accepts, so a dump can be edited and re-assembled.
+//
+// Source format
+//      One instruction per line :
+//
+//          [label:]  MNEMONIC  [[modifier] data]     ; comment
+//
+//      Operands are numbers (decimal or 0x hex), the names used in the
+//      robot code (V0..V15, EQ, LT, GT, SPEED, REGISTER, DRIVE_FORWARD,
+//      FRONT_SENSOR_C, SW_B, ...) or, for GOTO and CALL, a label.  With a
+//      single operand the modifier is 0.
+//
+// Build
+//      gcc -std=c99 -Wall -o robot_asm robot_asm.c
+//
+//----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+
+#include "../Sources/interpreter.h"
+
+#define   MAX_WORDS        100        // RAM_SEQUENCE_SIZE in user_defines.h
+#define   FLASH_SEQ_ADDR   0xF800     // FLASH_AREA2 in Project.prm
+#define   FLASH_SEQ_SIZE   512        // size of FLASH_seq_0
+#define   S19_LINE_BYTES   16
+#define   MAX_LINE         256
+#define   MAX_LABELS       MAX_WORDS
+#define   LABEL_SIZE       32
+
+//----------------------------------------------------------------------------
+// operand names : same values as the enums in interpreter.h and user_defines.h
+//
+typedef struct {
+    const char  *name;
+    uint8_t     value;
+} symbol_t;
+
+static const symbol_t  symbols[] = {
+    {"NO_MOD", NO_MOD}, {"IMMEDIATE", IMMEDIATE}, {"REGISTER", REGISTER}, {"STACK", STACK},
+    {"ABSOLUTE", ABSOLUTE}, {"RELATIVE_PLUS", RELATIVE_PLUS}, {"RELATIVE_MINUS", RELATIVE_MINUS},
+    {"DRIVE_FORWARD", DRIVE_FORWARD}, {"DRIVE_SPIN_LEFT", DRIVE_SPIN_LEFT},
+    {"DRIVE_SPIN_RIGHT", DRIVE_SPIN_RIGHT}, {"DRIVE_BACKWARD", DRIVE_BACKWARD},
+    {"SPEED", SPEED}, {"DISTANCE", DISTANCE}, {"TIME", TIME},
+    {"ADD", ADD},
+    {"MOVE_TIME", MOVE_TIME}, {"MOVE_DISTANCE", MOVE_DISTANCE}, {"START", START}, {"STOP", STOP},
+    {"EQ", EQ}, {"LT", LT}, {"GT", GT},
+    {"SW_A", SW_A}, {"SW_B", SW_B}, {"SW_C", SW_C}, {"SW_D", SW_D},
+    {"V0", V0}, {"V1", V1}, {"V2", V2}, {"V3", V3}, {"V4", V4}, {"V5", V5},
+    {"V6", V6}, {"V7", V7}, {"V8", V8}, {"V9", V9}, {"V10", V10}, {"V11", V11},
+    {"V12", V12}, {"V13", V13}, {"V14", V14}, {"V15", V15},
+    {"LEFT_MOTOR", 0}, {"RIGHT_MOTOR", 1},                      // motor_t
+    {"BATTERY_VOLTS", 0}, {"POT_3", 1}, {"POT_2", 2}, {"POT_1", 3},     // a2d_channels_t
+    {"PAD_SWL", 4}, {"PAD_SWR", 5}, {"LINE_SENSOR_L", 6}, {"LINE_SENSOR_R", 7},
+    {"FRONT_SENSOR_L", 8}, {"FRONT_SENSOR_C", 9}, {"FRONT_SENSOR_R", 10},
+    {"WHEEL_SENSOR_L", 11}, {"WHEEL_SENSOR_R", 12}, {"REAR_SENSOR", 13},
+};
+
+#define   NOS_SYMBOLS   (sizeof(symbols) / sizeof(symbols[0]))
+
+//
+// copy of 'inst_names' in interpreter.c (the robot code is not linked here)
+//
+static const char * const names[NOS_INSTRUCTIONS] = {
+    "PUSH_16", "PUSH_L8", "PUSH_H8", "POP_8", "POP_16", "SET_PARAMETER",
+    "COMPUTE", "GOTO", "EXECUTE", "DEC_AND_SKIP", "TEST_AND_SKIP", "READ_CHAN", "EXIT", "DELAY",
+    "SET_SPEEDS", "TIMED_MOVE", "DISTANCE_MOVE", "CALL", "RET",
+    "WAIT_UNTIL", "WAIT_WHEEL_COUNT", "WAIT_SWITCH",
+};
+
+static struct {
+    char        name[LABEL_SIZE];
+    uint8_t     address;
+} labels[MAX_LABELS];
+
+static uint8_t       nos_labels;
+static uint16_t      words[MAX_WORDS];
+static uint8_t       nos_words;
+static const char    *file_name;
+static int           line_number;
+
+//----------------------------------------------------------------------------
+// error : report an error in the input and exit
+// =====
+//
+static void error(const char *msg, const char *item)
+{
+    fprintf(stderr, "%s:%d: error: %s", file_name, line_number, msg);
+    if (item != NULL) {
+        fprintf(stderr, " '%s'", item);
+    }
+    fprintf(stderr, "\n");
+    exit(EXIT_FAILURE);
+}
+
+//----------------------------------------------------------------------------
+// strip_comment : remove a ';' or '//' comment and the line end
+// =============
+//
+static void strip_comment(char *line)
+{
+char   *p;
+
+    if ((p = strchr(line, ';')) != NULL) {
+        *p = '\0';
+    }
+    if ((p = strstr(line, "//")) != NULL) {
+        *p = '\0';
+    }
+    line[strcspn(line, "\r\n")] = '\0';
+}
+
+//----------------------------------------------------------------------------
+// parse_number : convert a decimal or hex string
+// ============
+//
+// Results
+//      0 if OK, -1 if the string is not a number
+//
+static int parse_number(const char *token, long *value)
+{
+char   *end;
+
+    if ((token == NULL) || !isdigit((unsigned char)token[0])) {
+        return -1;
+    }
+    *value = strtol(token, &end, 0);
+    return (*end == '\0') ? 0 : -1;
+}
+
+//----------------------------------------------------------------------------
+// find_mnemonic : look up an instruction name
+// =============
+//
+// Results
+//      op-code, or -1 if not found
+//
+static int find_mnemonic(const char *token)
+{
+int   i;
+
+    for (i = 0 ; i < NOS_INSTRUCTIONS ; i++) {
+        if (strcmp(token, names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int find_label(const char *token)
+{
+int   i;
+
+    for (i = 0 ; i < nos_labels ; i++) {
+        if (strcmp(token, labels[i].name) == 0) {
+            return labels[i].address;
+        }
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------------
+// operand_value : value of a number, symbol or label operand
+// =============
+//
+// Parameters
+//      token    : operand text
+//      op_code  : instruction being assembled
+//      modifier : its modifier (used for labels on GOTO/CALL)
+//
+static long operand_value(const char *token, int op_code, int modifier)
+{
+long    value;
+int     i, target;
+
+    if (parse_number(token, &value) == 0) {
+        return value;
+    }
+    for (i = 0 ; i < (int)NOS_SYMBOLS ; i++) {
+        if (strcmp(token, symbols[i].name) == 0) {
+            return symbols[i].value;
+        }
+    }
+    if ((op_code == GOTO) || (op_code == CALL)) {
+        target = find_label(token);
+        if (target < 0) {
+            error("undefined label", token);
+        }
+        switch (modifier) {
+            case RELATIVE_PLUS  : return target - nos_words;
+            case RELATIVE_MINUS : return nos_words - target;
+            default             : return target;
+        }
+    }
+    error("unknown operand", token);
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// assemble_line : assemble one source line
+// =============
+//
+// Parameters
+//      line : source text (modified)
+//      emit : 0 on the first pass (labels only), 1 on the second
+//
+static void assemble_line(char *line, int emit)
+{
+char    *token[5], *colon, *p;
+int     nos_tokens, op_code;
+long    modifier, data, value;
+
+    strip_comment(line);
+    p = line;
+    while (isspace((unsigned char)*p)) {
+        p++;
+    }
+    if ((colon = strchr(p, ':')) != NULL) {
+        *colon = '\0';
+        p[strcspn(p, " \t")] = '\0';
+        if (emit == 0) {
+            if ((*p == '\0') || (strlen(p) >= LABEL_SIZE)) {
+                error("bad label", p);
+            }
+            if (find_label(p) >= 0) {
+                error("duplicate label", p);
+            }
+            strcpy(labels[nos_labels].name, p);
+            labels[nos_labels++].address = nos_words;
+        }
+        p = colon + 1;
+    }
+    nos_tokens = 0;
+    for (p = strtok(p, " \t,") ; p != NULL ; p = strtok(NULL, " \t,")) {
+        if (nos_tokens == 5) {
+            error("too many operands", NULL);
+        }
+        token[nos_tokens++] = p;
+    }
+    if (nos_tokens == 0) {
+        return;
+    }
+    if (nos_words >= MAX_WORDS) {
+        error("sequence too long", NULL);
+    }
+    op_code = find_mnemonic(token[0]);
+    if (op_code < 0) {
+        error("unknown instruction", token[0]);
+    }
+    if (emit == 0) {
+        nos_words++;
+        return;
+    }
+    modifier = 0;
+    data = 0;
+    switch (nos_tokens) {
+        case 1 :
+            break;
+        case 2 :
+            data = operand_value(token[1], op_code, ABSOLUTE);
+            break;
+        case 3 :
+            modifier = operand_value(token[1], op_code, ABSOLUTE);
+            data = operand_value(token[2], op_code, (int)modifier);
+            break;
+        case 4 :                             // 'dump_sequence' format
+            if ((parse_number(token[1], &value) != 0) || (value != op_code)) {
+                error("op-code does not match name", token[1]);
+            }
+            modifier = operand_value(token[2], op_code, ABSOLUTE);
+            data = operand_value(token[3], op_code, (int)modifier);
+            break;
+        default :
+            error("too many operands", NULL);
+    }
+    if ((modifier < 0) || (modifier > 3)) {
+        error("modifier out of range (0-3)", token[nos_tokens - 2]);
+    }
+    if ((data < 0) || (data > 255)) {
+        error("data out of range (0-255)", token[nos_tokens - 1]);
+    }
+    words[nos_words++] = INSTRUCTION(op_code, modifier, data);
+}
+
+//----------------------------------------------------------------------------
+// assemble_file : two pass assembly of a source file into 'words'
+// =============
+//
+static void assemble_file(FILE *in)
+{
+char   line[MAX_LINE];
+int    pass;
+
+    for (pass = 0 ; pass < 2 ; pass++) {
+        rewind(in);
+        nos_words = 0;
+        line_number = 0;
+        while (fgets(line, sizeof(line), in) != NULL) {
+            line_number++;
+            assemble_line(line, pass);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+// pack_words : convert 'words' to the compact FLASH encoding
+// ==========
+//
+// Notes
+//      Same encoding as 'pack_instruction' in interpreter.c.
+//
+// Results
+//      number of bytes, including the PACKED_END marker
+//
+static int pack_words(uint8_t packed[])
+{
+int       i, size;
+uint16_t  command;
+
+    size = 0;
+    for (i = 0 ; i < nos_words ; i++) {
+        command = words[i];
+        if (INST_OP_CODE(command) >= PACKED_MAX_OP_CODE) {
+            line_number = 0;
+            error("op-code cannot be stored in FLASH", names[INST_OP_CODE(command)]);
+        }
+        if ((INST_MODIFIER(command) == 0) && (INST_DATA(command) <= 3)) {
+            packed[size++] = (uint8_t)((INST_DATA(command) << 6) | PACKED_SHORT | INST_OP_CODE(command));
+        } else {
+            packed[size++] = (uint8_t)(command >> 8);
+            packed[size++] = (uint8_t)command;
+        }
+    }
+    packed[size++] = PACKED_END;
+    return size;
+}
+
+//----------------------------------------------------------------------------
+// write_s19_record : write one Motorola S-record
+// ================
+//
+static void write_s19_record(FILE *out, char type, uint16_t address, const uint8_t data[], int count)
+{
+uint8_t   sum;
+int       i;
+
+    sum = (uint8_t)(count + 3) + (uint8_t)(address >> 8) + (uint8_t)address;
+    fprintf(out, "S%c%02X%04X", type, count + 3, address);
+    for (i = 0 ; i < count ; i++) {
+        fprintf(out, "%02X", data[i]);
+        sum += data[i];
+    }
+    fprintf(out, "%02X\n", (uint8_t)~sum);
+}
+
+static void write_s19(FILE *out)
+{
+uint8_t   packed[(MAX_WORDS * 2) + 1];
+int       size, i, count;
+
+    size = pack_words(packed);
+    if (size > FLASH_SEQ_SIZE) {
+        line_number = 0;
+        error("sequence too big for FLASH_seq_0", NULL);
+    }
+    write_s19_record(out, '0', 0, (const uint8_t *)"robot_seq", 9);
+    for (i = 0 ; i < size ; i += S19_LINE_BYTES) {
+        count = ((size - i) < S19_LINE_BYTES) ? (size - i) : S19_LINE_BYTES;
+        write_s19_record(out, '1', (uint16_t)(FLASH_SEQ_ADDR + i), &packed[i], count);
+    }
+    write_s19_record(out, '9', 0, NULL, 0);
+}
+
+static void write_words(FILE *out)
+{
+int   i;
+
+    for (i = 0 ; i < nos_words ; i++) {
+        fprintf(out, "    0x%04X,      // %s\n", words[i], names[INST_OP_CODE(words[i])]);
+    }
+}
+
+//----------------------------------------------------------------------------
+// read_s19_line : add the data of an S1 record of a packed sequence
+// =============
+//
+static void read_s19_line(const char *line, uint8_t packed[], int *size)
+{
+unsigned int   count, address, byte;
+int            i, offset;
+
+    if ((sscanf(line + 2, "%2x%4x", &count, &address) != 2) || (count < 3)) {
+        error("bad S1 record", NULL);
+    }
+    offset = (int)address - FLASH_SEQ_ADDR;
+    for (i = 0 ; i < (int)count - 3 ; i++, offset++) {
+        if ((sscanf(line + 8 + (i * 2), "%2x", &byte) != 1) ||
+            (offset < 0) || (offset >= FLASH_SEQ_SIZE)) {
+            error("bad S1 record", NULL);
+        }
+        packed[offset] = (uint8_t)byte;
+        if (offset >= *size) {
+            *size = offset + 1;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+// read_dump : read words from hex, 'dump_sequence' or S19 text
+// =========
+//
+static void read_dump(FILE *in)
+{
+char       line[MAX_LINE], *p;
+uint8_t    packed[FLASH_SEQ_SIZE + 1];
+int        size, i, op_code;
+uint16_t   command;
+long       value, modifier, data;
+
+    memset(packed, PACKED_END, sizeof(packed));
+    size = 0;
+    nos_words = 0;
+    line_number = 0;
+    while (fgets(line, sizeof(line), in) != NULL) {
+        line_number++;
+        if (strncmp(line, "S1", 2) == 0) {
+            read_s19_line(line, packed, &size);
+            continue;
+        }
+        if ((line[0] == 'S') || (strncmp(line, "Robot commands", 14) == 0)) {
+            continue;                          // other S-records, dump heading
+        }
+        strip_comment(line);
+        p = strtok(line, " \t,");
+        if (p == NULL) {
+            continue;
+        }
+        if (nos_words >= MAX_WORDS) {
+            error("sequence too long", NULL);
+        }
+        op_code = find_mnemonic(p);
+        if ((op_code >= 0) || (strcmp(p, "???") == 0)) {    // 'dump_sequence' line
+            if ((parse_number(strtok(NULL, " \t"), &value) != 0) ||
+                (parse_number(strtok(NULL, " \t"), &modifier) != 0) ||
+                (parse_number(strtok(NULL, " \t"), &data) != 0)) {
+                error("bad dump_sequence line", p);
+            }
+            words[nos_words++] = INSTRUCTION(value, modifier, data);
+            continue;
+        }
+        for ( ; p != NULL ; p = strtok(NULL, " \t,")) {
+            value = strtol(p, NULL, 16);
+            if ((strspn(p, "0123456789abcdefABCDEFxX") != strlen(p)) || (value < 0) || (value > 0xFFFF)) {
+                error("not a hex word", p);
+            }
+            if (nos_words >= MAX_WORDS) {
+                error("sequence too long", NULL);
+            }
+            words[nos_words++] = (uint16_t)value;
+        }
+    }
+    for (i = 0 ; (i < size) && (packed[i] != PACKED_END) ; ) {
+        if (nos_words >= MAX_WORDS) {
+            error("sequence too long", NULL);
+        }
+        if (packed[i] & PACKED_SHORT) {
+            command = INSTRUCTION(packed[i] & 0x1F, NO_MOD, packed[i] >> 6);
+            i += 1;
+        } else {
+            command = ((uint16_t)packed[i] << 8) | packed[i + 1];
+            i += 2;
+        }
+        words[nos_words++] = command;
+    }
+}
+
+//----------------------------------------------------------------------------
+// write_listing : print words in the 'dump_sequence' format
+// =============
+//
+static void write_listing(FILE *out)
+{
+int   i, op_code;
+
+    for (i = 0 ; i < nos_words ; i++) {
+        if (words[i] == 0xFFFF) {              // unused entries show as all 1's
+            break;
+        }
+        op_code = INST_OP_CODE(words[i]);
+        fprintf(out, "%s\t%d\t%d\t%d\n", (op_code < NOS_INSTRUCTIONS) ? names[op_code] : "???",
+                     op_code, INST_MODIFIER(words[i]), INST_DATA(words[i]));
+    }
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: robot_asm [-s | -d] [-o output] input\n"
+                    "    (none) assemble to 16-bit words (C initialiser)\n"
+                    "    -s     assemble to S19 packed sequence at 0x%04X\n"
+                    "    -d     disassemble hex words, dump_sequence text or S19\n", FLASH_SEQ_ADDR);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+int     i, mode;
+FILE    *in, *out;
+const char  *out_name;
+
+    mode = 'a';
+    out_name = NULL;
+    file_name = NULL;
+    for (i = 1 ; i < argc ; i++) {
+        if ((strcmp(argv[i], "-s") == 0) || (strcmp(argv[i], "-d") == 0)) {
+            mode = argv[i][1];
+        } else if ((strcmp(argv[i], "-o") == 0) && ((i + 1) < argc)) {
+            out_name = argv[++i];
+        } else if ((argv[i][0] != '-') && (file_name == NULL)) {
+            file_name = argv[i];
+        } else {
+            usage();
+        }
+    }
+    if (file_name == NULL) {
+        usage();
+    }
+    if ((in = fopen(file_name, "r")) == NULL) {
+        perror(file_name);
+        return EXIT_FAILURE;
+    }
+    out = stdout;
+    if ((out_name != NULL) && ((out = fopen(out_name, "w")) == NULL)) {
+        perror(out_name);
+        return EXIT_FAILURE;
+    }
+    switch (mode) {
+        case 'd' :
+            read_dump(in);
+            write_listing(out);
+            break;
+        case 's' :
+            assemble_file(in);
+            write_s19(out);
+            break;
+        default :
+            assemble_file(in);
+            write_words(out);
+            break;
+    }
+    fclose(in);
+    if (out != stdout) {
+        fclose(out);
+    }
+    return EXIT_SUCCESS;
+}
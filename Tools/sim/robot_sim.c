@@ -0,0 +1,588 @@
+//----------------------------------------------------------------------------
+//
+//                  Robokid
+//
+//----------------------------------------------------------------------------
+// robot_sim.c : run robot sequences on the PC
+// ===========
+//
+// Description
+//      Builds 'interpreter.c' and 'optimise.c' unchanged against a model of
+//      the robot hardware (sim_hw.c) to measure and test the interpreter
+//      without flashing a robot.
+//
+//          robot_sim [-O] [-n count] [file ...]    benchmark
+//          robot_sim -f runs [seed]                 fuzz with random sequences
+//
+//      The benchmark runs a set of built-in sequences and any recorded
+//      sequences given as files of hex words (the output of robot_asm or a
+//      memory dump), each repeatedly until 'count' instructions have been
+//      run (default 10000000).  It reports instructions per second and the
+//      data stack depth histogram for each.  -O optimises each sequence
+//      (optimise_sequence) before it is run.  The "pair" benchmark runs two
+//      sequences side by side and checks their private and shared (V12-V15)
+//      variables after every run.
+//
+//      Instructions are counted by the sequence profiler, which adds a small
+//      cost to each instruction.  Waits are completed by advancing the
+//      model by one 8mS tick, taking no real time.
+//
+// Fuzzing
+//      'LLVMFuzzerTestOneInput' checks that any byte string can be loaded,
+//      as 16-bit words, as two sequences run side by side and as a packed
+//      FLASH sequence, without faults, and that the optimiser keeps verified
+//      sequences verifiable and does not change what they do.  -f calls it with random input; for coverage
+//      guided fuzzing build it with -DSIM_LIBFUZZER and
+//      clang -fsanitize=fuzzer,address.
+//
+// Build
+//      gcc -O2 -DPROFILE_SEQUENCES -include sim_global.h -I../../Sources
+//          -o robot_sim robot_sim.c sim_hw.c
+//          ../../Sources/interpreter.c ../../Sources/optimise.c
+//
+//----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "sim_global.h"
+#include "sim_hw.h"
+
+#ifndef PROFILE_SEQUENCES
+#error "robot_sim needs -DPROFILE_SEQUENCES to count instructions"
+#endif
+
+#define   DEFAULT_BENCH_COUNT   10000000UL
+#define   HARVEST_STEPS         1000       // < 65536 / SEQUENCE_STEP_SIZE : profile counts are 16-bit
+#define   FUZZ_MAX_STEPS        20000      // runaway limit for one fuzz sequence
+#define   BENCH_MAX_STEPS       1000000    // runaway limit for one benchmark run
+#define   MAX_LINE              256
+
+//----------------------------------------------------------------------------
+// built-in benchmark sequences
+//
+static const uint16_t  bench_arith[] = {          // 250 x (V1 = V1 + 3)
+    INSTRUCTION(PUSH_16, IMMEDIATE, 250),
+    INSTRUCTION(POP_16, REGISTER, V0),
+    INSTRUCTION(PUSH_16, REGISTER, V1),           // 2 : loop
+    INSTRUCTION(PUSH_16, IMMEDIATE, 3),
+    INSTRUCTION(COMPUTE, NO_MOD, ADD),
+    INSTRUCTION(POP_16, REGISTER, V1),
+    INSTRUCTION(DEC_AND_SKIP, NO_MOD, V0),
+    INSTRUCTION(GOTO, ABSOLUTE, 2),
+    INSTRUCTION(EXIT, NO_MOD, NO_DATA),
+    END_OF_SEQUENCE
+};
+
+static const uint16_t  bench_call[] = {           // 250 x subroutine call
+    INSTRUCTION(PUSH_16, IMMEDIATE, 250),
+    INSTRUCTION(POP_16, REGISTER, V0),
+    INSTRUCTION(CALL, ABSOLUTE, 6),               // 2 : loop
+    INSTRUCTION(DEC_AND_SKIP, NO_MOD, V0),
+    INSTRUCTION(GOTO, RELATIVE_MINUS, 2),
+    INSTRUCTION(EXIT, NO_MOD, NO_DATA),
+    INSTRUCTION(PUSH_16, REGISTER, V2),           // 6 : subroutine
+    INSTRUCTION(PUSH_16, IMMEDIATE, 1),
+    INSTRUCTION(COMPUTE, NO_MOD, ADD),
+    INSTRUCTION(POP_16, REGISTER, V2),
+    INSTRUCTION(RET, NO_MOD, NO_DATA),
+    END_OF_SEQUENCE
+};
+
+static const uint16_t  bench_stack[] = {          // 100 x deep stack, constant folding candidates
+    INSTRUCTION(PUSH_16, IMMEDIATE, 100),
+    INSTRUCTION(POP_16, REGISTER, V0),
+    INSTRUCTION(PUSH_16, IMMEDIATE, 1),           // 2 : loop
+    INSTRUCTION(PUSH_16, IMMEDIATE, 2),
+    INSTRUCTION(PUSH_16, IMMEDIATE, 3),
+    INSTRUCTION(PUSH_L8, IMMEDIATE, 4),
+    INSTRUCTION(PUSH_H8, IMMEDIATE, 0),
+    INSTRUCTION(PUSH_16, REGISTER, V0),
+    INSTRUCTION(COMPUTE, NO_MOD, ADD),
+    INSTRUCTION(COMPUTE, NO_MOD, ADD),
+    INSTRUCTION(COMPUTE, NO_MOD, ADD),
+    INSTRUCTION(COMPUTE, NO_MOD, ADD),
+    INSTRUCTION(POP_16, REGISTER, V3),
+    INSTRUCTION(DEC_AND_SKIP, NO_MOD, V0),
+    INSTRUCTION(GOTO, ABSOLUTE, 2),
+    INSTRUCTION(EXIT, NO_MOD, NO_DATA),
+    END_OF_SEQUENCE
+};
+
+static const uint16_t  bench_sensor[] = {         // 20 x read sensors and wait a tick
+    INSTRUCTION(PUSH_16, IMMEDIATE, 20),
+    INSTRUCTION(POP_16, REGISTER, V0),
+    INSTRUCTION(READ_CHAN, IMMEDIATE, FRONT_SENSOR_C),   // 2 : loop
+    INSTRUCTION(POP_16, REGISTER, V12),
+    INSTRUCTION(PUSH_16, IMMEDIATE, 128),
+    INSTRUCTION(WAIT_UNTIL, GT, FRONT_SENSOR_L),
+    INSTRUCTION(DELAY, IMMEDIATE, 1),
+    INSTRUCTION(DEC_AND_SKIP, NO_MOD, V0),
+    INSTRUCTION(GOTO, ABSOLUTE, 2),
+    INSTRUCTION(EXIT, NO_MOD, NO_DATA),
+    END_OF_SEQUENCE
+};
+
+//
+// two sequences side by side : the main sequence counts 200 loops in V13
+// and reads the watcher's count from V12.  The watcher never ends; it
+// counts in V12, copies V13 to V14 and keeps 7 in its own V0.
+//
+static const uint16_t  bench_pair_main[] = {
+    INSTRUCTION(PUSH_16, IMMEDIATE, 200),
+    INSTRUCTION(POP_16, REGISTER, V0),
+    INSTRUCTION(PUSH_16, REGISTER, V12),          // 2 : loop
+    INSTRUCTION(POP_16, REGISTER, V1),
+    INSTRUCTION(PUSH_16, REGISTER, V13),
+    INSTRUCTION(PUSH_16, IMMEDIATE, 1),
+    INSTRUCTION(COMPUTE, NO_MOD, ADD),
+    INSTRUCTION(POP_16, REGISTER, V13),
+    INSTRUCTION(DEC_AND_SKIP, NO_MOD, V0),
+    INSTRUCTION(GOTO, ABSOLUTE, 2),
+    INSTRUCTION(EXIT, NO_MOD, NO_DATA),
+    END_OF_SEQUENCE
+};
+
+static const uint16_t  bench_pair_watcher[] = {
+    INSTRUCTION(PUSH_16, REGISTER, V12),          // 0 : loop
+    INSTRUCTION(PUSH_16, IMMEDIATE, 1),
+    INSTRUCTION(COMPUTE, NO_MOD, ADD),
+    INSTRUCTION(POP_16, REGISTER, V12),
+    INSTRUCTION(PUSH_16, REGISTER, V13),
+    INSTRUCTION(POP_16, REGISTER, V14),
+    INSTRUCTION(PUSH_16, IMMEDIATE, 7),
+    INSTRUCTION(POP_16, REGISTER, V0),
+    INSTRUCTION(GOTO, ABSOLUTE, 0),
+    END_OF_SEQUENCE
+};
+
+//----------------------------------------------------------------------------
+// check_pair : check the state left by the "pair" benchmark
+// ==========
+//
+// Description
+//      Each sequence must have kept its own V0, each must have seen the
+//      other's writes to the shared V12 and V13, and the watcher must have
+//      been stopped when the main sequence ended.
+//
+static uint8_t check_pair(void)
+{
+    if ((read_sequence_variable(0, V0) != 0) || (read_sequence_variable(1, V0) != 7)) {
+        return FAIL;
+    }
+    if ((read_sequence_variable(0, V13) != 200) || (read_sequence_variable(0, V1) == 0) ||
+        (read_sequence_variable(1, V14) == 0)) {
+        return FAIL;
+    }
+    return (sequence_running(1) == NO) ? OK : FAIL;
+}
+
+static const struct {
+    const char      *name;
+    const uint16_t  *sequences[MAX_SEQUENCES];
+    uint8_t         (*check)(void);           // test the state after each run, or NULL
+} bench_sequences[] = {
+    {"arith",  {bench_arith},  NULL},
+    {"call",   {bench_call},   NULL},
+    {"stack",  {bench_stack},  NULL},
+    {"sensor", {bench_sensor}, NULL},
+    {"pair",   {bench_pair_main, bench_pair_watcher}, check_pair},
+};
+
+#define   NOS_BENCH_SEQUENCES   (sizeof(bench_sequences) / sizeof(bench_sequences[0]))
+
+static unsigned long long   total_insts;
+static unsigned long long   total_depth[STACK_SIZE + 1];
+
+//
+// state left by a fuzz run of the main sequence (see 'record_run')
+//
+typedef struct {
+    uint8_t             status;               // 'run_to_end' result
+    uint16_t            ticks;
+    uint16_t            vars[V15 + 1];
+    uint8_t             depth;
+    uint16_t            stack[STACK_SIZE];
+    sim_motor_trace_t   trace;
+} run_result_t;
+
+//----------------------------------------------------------------------------
+// harvest_profile : add the 16-bit profile counts to the totals and clear them
+// ===============
+//
+static void harvest_profile(void)
+{
+uint8_t   i;
+
+    for (i = 0 ; i < NOS_INSTRUCTIONS ; i++) {
+        total_insts += sequence_profile[i].count;
+    }
+    for (i = 0 ; i <= STACK_SIZE ; i++) {
+        total_depth[i] += stack_depth_profile[i];
+    }
+    clear_sequence_profile();
+}
+
+//----------------------------------------------------------------------------
+// run_to_end : step the current sequences until done
+// ==========
+//
+// Parameters
+//      max_steps : calls to 'step_sequence' allowed, 0 = no limit
+// Results
+//      OK if the sequences finished, FAIL if the limit was reached
+//
+static uint8_t run_to_end(unsigned long max_steps)
+{
+unsigned long   steps;
+seq_status_t    status;
+
+    for (steps = 1 ; (max_steps == 0) || (steps <= max_steps) ; steps++) {
+        status = step_sequence(SEQUENCE_STEP_SIZE);
+        if (status == SEQ_DONE) {
+            return OK;
+        }
+        if (status == SEQ_WAITING) {
+            sim_tick();                        // the robot would sleep until the next RTI
+        }
+        if ((steps % HARVEST_STEPS) == 0) {
+            harvest_profile();
+        }
+    }
+    stop_sequence();
+    return FAIL;
+}
+
+//----------------------------------------------------------------------------
+// record_run : run the loaded sequences to the end and record what they did
+// ==========
+//
+static void record_run(run_result_t *result)
+{
+uint8_t   var;
+
+    result->status = run_to_end(FUZZ_MAX_STEPS);
+    result->ticks = tick_count_16;
+    for (var = V0 ; var <= V15 ; var++) {
+        result->vars[var] = read_sequence_variable(0, var);
+    }
+    result->depth = read_sequence_stack(0, result->stack);
+    result->trace = motor_trace;
+}
+
+//----------------------------------------------------------------------------
+// same_run : compare the records of two runs
+// ========
+//
+// Results
+//      YES if they finished the same way with the same variables, stack,
+//      motor calls and run time in ticks
+//
+static uint8_t same_run(const run_result_t *a, const run_result_t *b)
+{
+    if ((a->status != b->status) || (a->ticks != b->ticks) || (a->depth != b->depth)) {
+        return NO;
+    }
+    if ((a->trace.count != b->trace.count) || (a->trace.hash != b->trace.hash)) {
+        return NO;
+    }
+    if (memcmp(a->vars, b->vars, sizeof(a->vars)) != 0) {
+        return NO;
+    }
+    return (memcmp(a->stack, b->stack, a->depth * sizeof(a->stack[0])) == 0) ? YES : NO;
+}
+
+static double seconds_now(void)
+{
+struct timespec   now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec * 1e-9);
+}
+
+//----------------------------------------------------------------------------
+// copy_sequence : copy a sequence for loading, optionally optimised
+// =============
+//
+// Results
+//      number of instructions, the rest of 'code' is END_OF_SEQUENCE
+//
+static uint8_t copy_sequence(uint16_t code[], const uint16_t sequence[], int optimise)
+{
+uint8_t   i, length;
+
+    for (length = 0 ; (length < RAM_SEQUENCE_SIZE) && (sequence[length] != END_OF_SEQUENCE) ; length++) {
+        code[length] = sequence[length];
+    }
+    if (optimise) {
+        length = optimise_sequence(code, length);
+    }
+    for (i = length ; i < RAM_SEQUENCE_SIZE ; i++) {
+        code[i] = END_OF_SEQUENCE;
+    }
+    return length;
+}
+
+//----------------------------------------------------------------------------
+// bench_sequence : run a set of sequences repeatedly and report the throughput
+// ==============
+//
+// Parameters
+//      sequences : main sequence followed by any to run alongside it, NULL
+//                  ends the list early
+//      check     : called after each run, NULL for none
+//
+static void bench_sequence(const char *name, const uint16_t * const sequences[], uint8_t (*check)(void),
+                           unsigned long long count, int optimise)
+{
+uint16_t            code[MAX_SEQUENCES][RAM_SEQUENCE_SIZE];
+uint8_t             i, length, nos_sequences, status;
+double              start, elapsed;
+unsigned long long  runs;
+
+    length = 0;
+    for (nos_sequences = 0 ; (nos_sequences < MAX_SEQUENCES) && (sequences[nos_sequences] != NULL) ; nos_sequences++) {
+        length += copy_sequence(code[nos_sequences], sequences[nos_sequences], optimise);
+    }
+    sim_reset();
+    clear_sequence_profile();
+    total_insts = 0;
+    memset(total_depth, 0, sizeof(total_depth));
+    runs = 0;
+    start = seconds_now();
+    do {
+        status = start_sequence(code[0]);
+        for (i = 1 ; (i < nos_sequences) && (status == OK) ; i++) {
+            status = add_sequence(code[i]);
+        }
+        if (status != OK) {
+            printf("%-12s rejected by verifier\n", name);
+            return;
+        }
+        if (run_to_end(BENCH_MAX_STEPS) != OK) {
+            printf("%-12s did not finish\n", name);
+            exit(EXIT_FAILURE);
+        }
+        if ((check != NULL) && (check() != OK)) {
+            printf("%-12s wrong result after %llu runs\n", name, runs);
+            exit(EXIT_FAILURE);
+        }
+        harvest_profile();
+        runs++;
+    } while (total_insts < count);
+    elapsed = seconds_now() - start;
+
+    printf("%-12s %3u words %8llu runs %12llu insts %8.2f Minst/s   depth %%",
+           name, length, runs, total_insts, ((double)total_insts / elapsed) * 1e-6);
+    for (i = 0 ; i <= STACK_SIZE ; i++) {
+        printf(" %3.0f", (total_insts == 0) ? 0.0 : ((double)total_depth[i] * 100.0) / (double)total_insts);
+    }
+    printf("\n");
+}
+
+//----------------------------------------------------------------------------
+// read_sequence_file : read a recorded sequence of hex words
+// ==================
+//
+// Notes
+//      Text after ';' or '//' is ignored, so robot_asm output can be used.
+//
+static uint8_t read_sequence_file(const char *file_name, uint16_t sequence[])
+{
+FILE            *in;
+char            line[MAX_LINE], *p, *end;
+unsigned long   value;
+uint8_t         length;
+
+    if ((in = fopen(file_name, "r")) == NULL) {
+        perror(file_name);
+        exit(EXIT_FAILURE);
+    }
+    length = 0;
+    while (fgets(line, sizeof(line), in) != NULL) {
+        line[strcspn(line, ";")] = '\0';
+        if ((p = strstr(line, "//")) != NULL) {
+            *p = '\0';
+        }
+        for (p = strtok(line, " \t\r\n,") ; p != NULL ; p = strtok(NULL, " \t\r\n,")) {
+            value = strtoul(p, &end, 16);
+            if ((*end != '\0') || (value > 0xFFFF) || (length >= RAM_SEQUENCE_SIZE)) {
+                fprintf(stderr, "%s: bad or too many words at '%s'\n", file_name, p);
+                exit(EXIT_FAILURE);
+            }
+            sequence[length++] = (uint16_t)value;
+        }
+    }
+    fclose(in);
+    if (length < RAM_SEQUENCE_SIZE) {
+        sequence[length] = END_OF_SEQUENCE;
+    }
+    return length;
+}
+
+//----------------------------------------------------------------------------
+// LLVMFuzzerTestOneInput : fuzz entry point
+// ======================
+//
+// Description
+//      The input is loaded as big-endian 16-bit words and as a packed FLASH
+//      sequence.  Whatever loads is run, with a step limit.  A sequence that
+//      passes the verifier must still pass it after optimisation and, if it
+//      finished, the optimised sequence must finish with the same variables,
+//      stack, motor calls and run time in ticks.  The words are also split in two and run as a main and a second sequence
+//      side by side : when the main sequence ends the second must have
+//      been stopped with it.
+//
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+uint16_t       code[RAM_SEQUENCE_SIZE], main_code[RAM_SEQUENCE_SIZE], second[RAM_SEQUENCE_SIZE];
+uint8_t        i, length, half;
+run_result_t   plain, optimised;
+
+    length = 0;
+    for (i = 0 ; i < RAM_SEQUENCE_SIZE ; i++) {
+        if (((size_t)i * 2 + 1) < size) {
+            code[i] = (uint16_t)((data[i * 2] << 8) | data[(i * 2) + 1]);
+            length++;
+        } else {
+            code[i] = END_OF_SEQUENCE;
+        }
+    }
+    half = length / 2;
+    for (i = 0 ; i < RAM_SEQUENCE_SIZE ; i++) {
+        main_code[i] = (i < half) ? code[i] : END_OF_SEQUENCE;
+        second[i] = ((half + i) < length) ? code[half + i] : END_OF_SEQUENCE;
+    }
+    sim_reset();
+    if (start_sequence(code) == OK) {
+        record_run(&plain);
+        length = optimise_sequence(code, length);
+        for (i = length ; i < RAM_SEQUENCE_SIZE ; i++) {
+            code[i] = END_OF_SEQUENCE;
+        }
+        sim_reset();
+        if (start_sequence(code) != OK) {
+            fprintf(stderr, "optimised sequence rejected by verifier\n");
+            abort();
+        }
+        record_run(&optimised);
+        if ((plain.status == OK) && (same_run(&plain, &optimised) == NO)) {
+            fprintf(stderr, "optimised sequence behaves differently\n");
+            abort();
+        }
+    }
+    sim_reset();
+    if ((start_sequence(main_code) == OK) && (add_sequence(second) == OK)) {
+        if ((run_to_end(FUZZ_MAX_STEPS) == OK) && (sequence_running(1) == YES)) {
+            fprintf(stderr, "second sequence still running after the main sequence ended\n");
+            abort();
+        }
+    }
+    sim_reset();
+    if (start_packed_sequence(data, (uint16_t)((size > 0xFFFF) ? 0xFFFF : size)) == OK) {
+        run_to_end(FUZZ_MAX_STEPS);
+    }
+    clear_sequence_profile();
+    return 0;
+}
+
+#ifndef SIM_LIBFUZZER
+//----------------------------------------------------------------------------
+// fuzz : feed random instruction streams to the fuzz entry point
+// ====
+//
+// Notes
+//      Op-codes, modifiers and data are biased towards valid values so
+//      that many sequences get past the verifier.  Most GOTO and CALL
+//      targets are kept inside the sequence and the patterns rewritten by
+//      'optimise_sequence' are mixed in, so that the optimised and
+//      unoptimised runs are often different code.
+//
+static void fuzz(unsigned long runs, unsigned int seed)
+{
+uint8_t         data[RAM_SEQUENCE_SIZE * 2];
+uint16_t        words[RAM_SEQUENCE_SIZE];
+unsigned long   run;
+uint8_t         i, length, op_code;
+
+    srand(seed);
+    for (run = 0 ; run < runs ; run++) {
+        length = (uint8_t)(rand() % (RAM_SEQUENCE_SIZE + 1));
+        for (i = 0 ; i < length ; i++) {
+            switch (rand() % 16) {
+                case 0 :
+                    words[i] = (uint16_t)rand();
+                    break;
+                case 1 :                           // constant in two halves
+                    words[i] = INSTRUCTION(PUSH_L8, IMMEDIATE, rand() % 256);
+                    if ((i + 1) < length) {
+                        words[++i] = INSTRUCTION(PUSH_H8, IMMEDIATE, (rand() % 2) ? 0 : (rand() % 256));
+                    }
+                    break;
+                case 2 :                           // constant addition
+                    words[i] = INSTRUCTION(PUSH_16, IMMEDIATE, rand() % 256);
+                    if ((i + 2) < length) {
+                        words[++i] = INSTRUCTION(PUSH_16, IMMEDIATE, rand() % 256);
+                        words[++i] = INSTRUCTION(COMPUTE, NO_MOD, ADD);
+                    }
+                    break;
+                case 3 :                           // GOTO the next instruction
+                    words[i] = INSTRUCTION(GOTO, RELATIVE_PLUS, 1);
+                    break;
+                default :
+                    op_code = (uint8_t)(rand() % NOS_INSTRUCTIONS);
+                    if (((op_code == GOTO) || (op_code == CALL)) && ((rand() % 4) != 0)) {
+                        words[i] = INSTRUCTION(op_code, ABSOLUTE, rand() % length);
+                    } else {
+                        words[i] = INSTRUCTION(op_code, rand() % 4,
+                                               ((rand() % 2) ? (rand() % 16) : (rand() % 256)));
+                    }
+                    break;
+            }
+        }
+        for (i = 0 ; i < length ; i++) {
+            data[i * 2] = (uint8_t)(words[i] >> 8);
+            data[(i * 2) + 1] = (uint8_t)words[i];
+        }
+        LLVMFuzzerTestOneInput(data, (size_t)length * 2);
+    }
+    printf("%lu random sequences run (seed %u)\n", runs, seed);
+}
+
+int main(int argc, char *argv[])
+{
+uint16_t             sequence[RAM_SEQUENCE_SIZE];
+const uint16_t       *file_sequences[MAX_SEQUENCES] = {sequence};
+unsigned long long   count;
+int                  i, first_file, optimise;
+
+    if ((argc >= 3) && (strcmp(argv[1], "-f") == 0)) {
+        fuzz(strtoul(argv[2], NULL, 0), (argc >= 4) ? (unsigned int)strtoul(argv[3], NULL, 0) : 1);
+        return EXIT_SUCCESS;
+    }
+    count = DEFAULT_BENCH_COUNT;
+    optimise = 0;
+    for (i = 1 ; (i < argc) && (argv[i][0] == '-') ; i++) {
+        if (strcmp(argv[i], "-O") == 0) {
+            optimise = 1;
+        } else if ((strcmp(argv[i], "-n") == 0) && ((i + 1) < argc)) {
+            count = strtoull(argv[++i], NULL, 0);
+        } else {
+            fprintf(stderr, "usage: robot_sim [-O] [-n count] [file ...]\n"
+                            "       robot_sim -f runs [seed]\n");
+            return EXIT_FAILURE;
+        }
+    }
+    first_file = i;
+    for (i = 0 ; i < (int)NOS_BENCH_SEQUENCES ; i++) {
+        bench_sequence(bench_sequences[i].name, bench_sequences[i].sequences, bench_sequences[i].check,
+                       count, optimise);
+    }
+    for (i = first_file ; i < argc ; i++) {
+        read_sequence_file(argv[i], sequence);
+        bench_sequence(argv[i], file_sequences, NULL, count, optimise);
+    }
+    return EXIT_SUCCESS;
+}
+#endif /* SIM_LIBFUZZER */
@@ -0,0 +1,89 @@
+//----------------------------------------------------------------------------
+//
+//                  Robokid
+//
+//----------------------------------------------------------------------------
+// sim_global.h : host replacement for global.h when simulating sequences
+// ============
+//
+// Description
+//      Pre-included (gcc -include sim_global.h) when 'interpreter.c' and
+//      'optimise.c' are built on the PC.  It defines the '__global_H' guard
+//      so the target 'global.h' they include is skipped, and supplies the
+//      small part of the system they use.  The hardware calls are modelled
+//      in 'sim_hw.c'.
+//
+//      Values must match the target definitions in user_defines.h.
+//
+//----------------------------------------------------------------------------
+
+#ifndef __global_H
+#define __global_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define   FOREVER              for(;;)
+#define   OK                   0
+#define   FAIL                 1
+#define   PRESSED              0
+#define   RELEASED             1
+#define   RAM_SEQUENCE_SIZE    100
+#define   PWM_COUNT            4000
+
+//
+// no interrupts on the host : the simulator updates the "RTI" variables
+// between calls to 'step_sequence'
+//
+#define   CLR_TIMER16              { tick_count_16 = 0; }
+#define   GET_TIMER16(variable)    { (variable) = tick_count_16; }
+#define   DISABLE_INTERRUPTS
+#define   ENABLE_INTERRUPTS
+#define   CPU_WAIT
+#define   CPU_IDLE
+#define   WAIT_SWITCH_RELEASED(switch_n)      while((switch_n) == PRESSED);
+
+typedef enum {MOTOR_OFF, MOTOR_FORWARD, MOTOR_BACKWARD, MOTOR_BRAKE} motor_state_t;
+typedef enum {LEFT_MOTOR, RIGHT_MOTOR} motor_t;
+typedef enum {
+        BATTERY_VOLTS,
+        POT_3, POT_2, POT_1,
+        PAD_SWL,PAD_SWR,
+        LINE_SENSOR_L, LINE_SENSOR_R,
+        FRONT_SENSOR_L, FRONT_SENSOR_C, FRONT_SENSOR_R,
+        WHEEL_SENSOR_L, WHEEL_SENSOR_R, REAR_SENSOR
+} a2d_channels_t;
+
+typedef struct {
+    uint8_t    mode, note_count;
+} sound_file_t;
+
+extern  volatile uint16_t   tick_count_16;
+extern  volatile uint8_t    tick_count_8;
+extern  volatile uint16_t   TPM1CNT;
+extern  uint8_t     switch_A, switch_B, switch_C, switch_D;
+extern  uint16_t    left_wheel_count, right_wheel_count;
+extern  uint8_t     left_motor_tweak, right_motor_tweak;
+extern  const sound_file_t   snd_fault;
+
+typedef struct  {
+    uint8_t     op_code;
+    uint8_t     modifier;
+    uint16_t    data;
+} sim_robot_command_t;
+
+extern  sim_robot_command_t  robot_command;
+
+uint8_t get_adc(a2d_channels_t chan);
+void set_motor(motor_t unit, motor_state_t state, uint8_t pwm_width);
+void vehicle_stop(void);
+uint8_t move_distance(uint16_t encoder_counts, motor_t unit, int8_t l_speed, int8_t r_speed);
+void start_move_distance(int8_t l_speed, int8_t r_speed);
+uint8_t move_distance_done(uint16_t encoder_counts, motor_t unit);
+void play_tune(const sound_file_t  *sound_file_pt);
+
+#include "clock.h"
+#include "interpreter.h"
+#include "optimise.h"
+
+#endif /* __global_H */
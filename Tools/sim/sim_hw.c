@@ -0,0 +1,153 @@
+//----------------------------------------------------------------------------
+//
+//                  Robokid
+//
+//----------------------------------------------------------------------------
+// sim_hw.c : host model of the hardware used by the sequence interpreter
+// ========
+//
+// Description
+//      Motor calls are only recorded (see 'motor_trace').  Each call to 'sim_tick' stands for one 8mS RTI
+//      interrupt : the tick counter and both wheel encoder counts advance,
+//      every a/d channel steps through all 256 values and switches B, C
+//      and D are pressed and released in turn.  Switch A (abort) is never
+//      pressed.  Every wait instruction therefore completes in a bounded
+//      number of ticks.
+//
+//----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim_global.h"
+#include "sim_hw.h"
+
+volatile uint16_t   tick_count_16;
+volatile uint8_t    tick_count_8;
+volatile uint16_t   TPM1CNT;
+uint8_t     switch_A, switch_B, switch_C, switch_D;
+uint16_t    left_wheel_count, right_wheel_count;
+uint8_t     left_motor_tweak, right_motor_tweak;
+const sound_file_t   snd_fault;
+
+sim_robot_command_t  robot_command;
+sim_motor_trace_t    motor_trace;
+
+static uint8_t    adc_values[REAR_SENSOR + 1];
+
+enum { TRACE_SET_MOTOR, TRACE_VEHICLE_STOP, TRACE_START_MOVE };
+
+//----------------------------------------------------------------------------
+// trace_motor : add a motor call to 'motor_trace'
+// ===========
+//
+// Notes
+//      FNV-1a hash of the call, its arguments and the tick it was made in.
+//
+static void trace_motor(uint8_t call, uint8_t arg1, uint8_t arg2, uint8_t arg3)
+{
+uint8_t   bytes[6], i;
+
+    bytes[0] = call;
+    bytes[1] = arg1;
+    bytes[2] = arg2;
+    bytes[3] = arg3;
+    bytes[4] = (uint8_t)tick_count_16;
+    bytes[5] = (uint8_t)(tick_count_16 >> 8);
+    for (i = 0 ; i < sizeof(bytes) ; i++) {
+        motor_trace.hash = (motor_trace.hash ^ bytes[i]) * 16777619UL;
+    }
+    motor_trace.count++;
+}
+
+//----------------------------------------------------------------------------
+// sim_reset : return the model to its power-up state
+// =========
+//
+void sim_reset(void)
+{
+uint8_t   i;
+
+    tick_count_16 = 0;
+    tick_count_8 = 0;
+    switch_A = switch_B = switch_C = switch_D = RELEASED;
+    left_wheel_count = right_wheel_count = 0;
+    left_motor_tweak = right_motor_tweak = 0;
+    motor_trace.count = 0;
+    motor_trace.hash = 2166136261UL;
+    for (i = 0 ; i <= REAR_SENSOR ; i++) {
+        adc_values[i] = (uint8_t)(i * 16);
+    }
+}
+
+//----------------------------------------------------------------------------
+// sim_tick : model one 8mS RTI period
+// ========
+//
+void sim_tick(void)
+{
+uint8_t   i, phase;
+
+    tick_count_16++;
+    tick_count_8++;
+    left_wheel_count++;
+    right_wheel_count++;
+    for (i = 0 ; i <= REAR_SENSOR ; i++) {
+        adc_values[i] += 7;                    // 7 and 256 co-prime : all values seen
+    }
+    phase = (uint8_t)(tick_count_16 & 0x0F);   // each switch down for 2 ticks in 16
+    switch_B = (phase == 2 || phase == 3)   ? PRESSED : RELEASED;
+    switch_C = (phase == 6 || phase == 7)   ? PRESSED : RELEASED;
+    switch_D = (phase == 10 || phase == 11) ? PRESSED : RELEASED;
+}
+
+//----------------------------------------------------------------------------
+// hardware calls made by the interpreter
+//
+uint8_t get_adc(a2d_channels_t chan)
+{
+    if (chan > REAR_SENSOR) {
+        fprintf(stderr, "get_adc : channel %u not connected\n", chan);
+        abort();
+    }
+    return adc_values[chan];
+}
+
+void set_motor(motor_t unit, motor_state_t state, uint8_t pwm_width)
+{
+    trace_motor(TRACE_SET_MOTOR, (uint8_t)unit, (uint8_t)state, pwm_width);
+}
+
+void vehicle_stop(void)
+{
+    trace_motor(TRACE_VEHICLE_STOP, 0, 0, 0);
+}
+
+void start_move_distance(int8_t l_speed, int8_t r_speed)
+{
+    trace_motor(TRACE_START_MOVE, (uint8_t)l_speed, (uint8_t)r_speed, 0);
+    left_wheel_count = right_wheel_count = 0;
+}
+
+uint8_t move_distance_done(uint16_t encoder_counts, motor_t unit)
+{
+uint16_t   count;
+
+    count = (unit == LEFT_MOTOR) ? left_wheel_count : right_wheel_count;
+    return (count >= encoder_counts) ? YES : NO;
+}
+
+uint8_t move_distance(uint16_t encoder_counts, motor_t unit, int8_t l_speed, int8_t r_speed)
+{
+    start_move_distance(l_speed, r_speed);
+    while (move_distance_done(encoder_counts, unit) == NO) {
+        sim_tick();
+    }
+    vehicle_stop();
+    return OK;
+}
+
+void play_tune(const sound_file_t  *sound_file_pt)
+{
+    (void)sound_file_pt;
+}
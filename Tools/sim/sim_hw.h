@@ -0,0 +1,25 @@
+//----------------------------------------------------------------------------
+// sim_hw.h
+// ========
+//
+//----------------------------------------------------------------------------
+//
+#ifndef __sim_hw_H
+#define __sim_hw_H
+
+//
+// record of the motor calls made since 'sim_reset' : two runs that make
+// the same calls with the same arguments at the same ticks have the same
+// count and hash
+//
+typedef struct {
+    uint32_t    count;
+    uint32_t    hash;
+} sim_motor_trace_t;
+
+extern sim_motor_trace_t   motor_trace;
+
+void sim_reset(void);
+void sim_tick(void);
+
+#endif /* __sim_hw_H */